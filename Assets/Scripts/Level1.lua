@@ -25,6 +25,52 @@ Level = {
         scale = 2.0
     },
 
+    ----------------------------------------------------
+    -- table to define the collision settings
+    ----------------------------------------------------
+    collision = {
+        broadphase = "spatial_hash", -- "spatial_hash", "sweep_and_prune", "aabb_tree" or "brute_force"
+        cell_size = 64, -- spatial hash cell side in pixels
+        fat_margin = 8 -- pixels the aabb tree leaves are grown by around the colliders
+    },
+
+    ----------------------------------------------------
+    -- table to define prefabs, reusable sets of components
+    -- that entities can be based on with prefab = "name"
+    ----------------------------------------------------
+    prefabs = {
+        tank = {
+            group = "enemies",
+            components = {
+                sprite = {
+                    texture_asset_id = "tank-texture",
+                    width = 32,
+                    height = 32,
+                    z_index = 2
+                },
+                boxcollider = {
+                    width = 25,
+                    height = 18,
+                    offset = { x = 0, y = 7 },
+                    -- layers: "default", "player", "enemies", "projectiles", "obstacles" or "all"
+                    -- two colliders only collide if each one has a layer of the other in its mask
+                    layer = "enemies",
+                    mask = { "projectiles", "obstacles" }
+                },
+                health = {
+                    health_percentage = 100
+                },
+                projectile_emitter = {
+                    projectile_velocity = { x = 100, y = 0 },
+                    projectile_duration = 2, -- seconds
+                    repeat_frequency = 1, -- seconds
+                    hit_percentage_damage = 20,
+                    friendly = false
+                }
+            }
+        }
+    },
+
     ----------------------------------------------------
     -- table to define entities and their components
     ----------------------------------------------------
@@ -58,7 +104,9 @@ Level = {
                 boxcollider = {
                     width = 32,
                     height = 25,
-                    offset = { x = 0, y = 5 }
+                    offset = { x = 0, y = 5 },
+                    layer = "player",
+                    mask = { "projectiles" }
                 },
                 health = {
                     health_percentage = 100
@@ -83,33 +131,12 @@ Level = {
         },
         {
             -- Tank
-            group = "enemies",
+            prefab = "tank",
             components = {
                 transform = {
                     position = { x = 200, y = 497 },
                     scale = { x = 1.0, y = 1.0 },
                     rotation = 0.0, -- degrees
-                },
-                sprite = {
-                    texture_asset_id = "tank-texture",
-                    width = 32,
-                    height = 32,
-                    z_index = 2
-                },
-                boxcollider = {
-                    width = 25,
-                    height = 18,
-                    offset = { x = 0, y = 7 }
-                },
-                health = {
-                    health_percentage = 100
-                },
-                projectile_emitter = {
-                    projectile_velocity = { x = 100, y = 0 },
-                    projectile_duration = 2, -- seconds
-                    repeat_frequency = 1, -- seconds
-                    hit_percentage_damage = 20,
-                    friendly = false
                 }
             }
         }
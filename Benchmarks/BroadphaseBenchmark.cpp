@@ -0,0 +1,225 @@
+#include "../Source/Broadphase/Broadphase.h"
+#include "../Source/Broadphase/DynamicAABBTree.h"
+#include "../Source/Broadphase/SpatialHashGrid.h"
+#include "../Source/Broadphase/SweepAndPrune.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// BroadphaseBenchmark
+////////////////////////////////////////////////////////////////////////////////
+// Compares the collision broadphases on scenes of 300 to 10000 colliders:
+// random 4-32 px boxes on a 1600x1280 map, moving up to 3 px per frame and
+// bouncing off the map edges. Every broadphase gets the same 60 frames, so the
+// ones that keep state between frames (sweep and prune) see the boxes move,
+// and the average time of a frame (finding the pairs and sorting them, as the
+// collision system does) is printed. The brute force reference is skipped on
+// the largest scenes, where it takes seconds. Last, region queries of the
+// AABB tree, the size of the camera and of a small area around a point, are
+// compared with a linear pass over the boxes.
+////////////////////////////////////////////////////////////////////////////////
+
+const float MAP_WIDTH = 1600.0f;
+const float MAP_HEIGHT = 1280.0f;
+const int FRAME_COUNT = 60;
+const int BRUTE_FORCE_MAX_COLLIDERS = 3000;
+const int NO_COLLIDER_LIMIT = std::numeric_limits<int>::max();
+const int QUERY_COLLIDER_COUNT = 10000;
+
+struct QueryRegion
+{
+    const char* name;
+    float width;
+    float height;
+};
+
+// The camera, and an area around a point such as an explosion
+const QueryRegion QUERY_REGIONS[] = {
+    { "800x600", 800.0f, 600.0f },
+    { "64x64", 64.0f, 64.0f }
+};
+
+struct Scene
+{
+    std::vector<AABB> boxes;
+    std::vector<int> keys;
+    std::vector<CollisionFilter> filters;
+    std::vector<float> velocitiesX;
+    std::vector<float> velocitiesY;
+};
+
+static Scene MakeScene(int colliderCount)
+{
+    // Same seed for every broadphase, so they get the same scene
+    std::mt19937 random(colliderCount);
+    std::uniform_real_distribution<float> size(4.0f, 32.0f);
+    std::uniform_real_distribution<float> velocity(-3.0f, 3.0f);
+
+    Scene scene;
+    for (int i = 0; i < colliderCount; i++)
+    {
+        const float width = size(random);
+        const float height = size(random);
+        const float x = std::uniform_real_distribution<float>(0.0f, MAP_WIDTH - width)(random);
+        const float y = std::uniform_real_distribution<float>(0.0f, MAP_HEIGHT - height)(random);
+        scene.boxes.push_back({ x, y, x + width, y + height });
+        scene.keys.push_back(i);
+        scene.filters.push_back({ 1, 1 });
+        scene.velocitiesX.push_back(velocity(random));
+        scene.velocitiesY.push_back(velocity(random));
+    }
+    return scene;
+}
+
+static void MoveScene(Scene& scene)
+{
+    for (size_t i = 0; i < scene.boxes.size(); i++)
+    {
+        AABB& box = scene.boxes[i];
+        if (box.minX + scene.velocitiesX[i] < 0.0f || box.maxX + scene.velocitiesX[i] > MAP_WIDTH)
+        {
+            scene.velocitiesX[i] = -scene.velocitiesX[i];
+        }
+        if (box.minY + scene.velocitiesY[i] < 0.0f || box.maxY + scene.velocitiesY[i] > MAP_HEIGHT)
+        {
+            scene.velocitiesY[i] = -scene.velocitiesY[i];
+        }
+        box.minX += scene.velocitiesX[i];
+        box.maxX += scene.velocitiesX[i];
+        box.minY += scene.velocitiesY[i];
+        box.maxY += scene.velocitiesY[i];
+    }
+}
+
+// Average milliseconds of a frame over the scene's frames. Adds the pairs found to pairCount.
+static double MeasureFrames(IBroadphase& broadphase, Scene scene, size_t& pairCount)
+{
+    std::vector<BroadphasePair> pairs;
+    double totalMilliseconds = 0.0;
+    for (int frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        pairs.clear();
+        broadphase.FindPairs(scene.boxes, scene.keys, scene.filters, pairs);
+        std::sort(pairs.begin(), pairs.end());
+        totalMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        pairCount += pairs.size();
+        MoveScene(scene);
+    }
+    return totalMilliseconds / FRAME_COUNT;
+}
+
+// Average milliseconds of a query of the region over the scene's frames, by the tree and by a linear pass. The tree
+// is updated every frame as the collision system does, outside the timing. Adds the boxes found to the counts.
+static void MeasureRegionQueries(Scene scene, const AABB& region, double& treeMilliseconds, double& linearMilliseconds, size_t& treeCount, size_t& linearCount)
+{
+    DynamicAABBTree tree;
+    treeMilliseconds = 0.0;
+    linearMilliseconds = 0.0;
+    for (int frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        tree.Update(scene.boxes, scene.keys);
+
+        auto start = std::chrono::steady_clock::now();
+        tree.Query(region, [&](int, int)
+        {
+            treeCount++;
+        });
+        treeMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (const AABB& box : scene.boxes)
+        {
+            linearCount += Overlaps(box, region);
+        }
+        linearMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        MoveScene(scene);
+    }
+    treeMilliseconds /= FRAME_COUNT;
+    linearMilliseconds /= FRAME_COUNT;
+}
+
+// A broadphase measured by the benchmark, made anew for every scene
+struct BenchmarkedBroadphase
+{
+    const char* name;
+    std::unique_ptr<IBroadphase> (*create)();
+
+    // Larger scenes are skipped
+    int maxColliderCount;
+};
+
+int main()
+{
+    const BenchmarkedBroadphase broadphases[] = {
+        { "brute force", []() -> std::unique_ptr<IBroadphase> { return std::make_unique<BruteForceBroadphase>(); }, BRUTE_FORCE_MAX_COLLIDERS },
+        { "spatial hash", []() -> std::unique_ptr<IBroadphase> { return std::make_unique<SpatialHashGrid>(); }, NO_COLLIDER_LIMIT },
+        { "sweep and prune", []() -> std::unique_ptr<IBroadphase> { return std::make_unique<SweepAndPrune>(); }, NO_COLLIDER_LIMIT },
+        { "aabb tree", []() -> std::unique_ptr<IBroadphase> { return std::make_unique<DynamicAABBTree>(); }, NO_COLLIDER_LIMIT }
+    };
+
+    std::printf("Average ms per frame over %d frames, broadphase + pair sort\n", FRAME_COUNT);
+    std::printf("%-10s", "colliders");
+    for (const auto& broadphase : broadphases)
+    {
+        std::printf(" %-16s", broadphase.name);
+    }
+    std::printf(" pairs per frame\n");
+
+    for (int colliderCount : { 300, 1000, 3000, 10000 })
+    {
+        const Scene scene = MakeScene(colliderCount);
+        std::printf("%-10d", colliderCount);
+
+        // Every broadphase must find the same number of pairs
+        size_t expectedPairCount = 0;
+        bool isMismatch = false;
+        for (const auto& broadphase : broadphases)
+        {
+            if (colliderCount > broadphase.maxColliderCount)
+            {
+                std::printf(" %-16s", "-");
+                continue;
+            }
+
+            size_t pairCount = 0;
+            const double milliseconds = MeasureFrames(*broadphase.create(), scene, pairCount);
+            isMismatch |= expectedPairCount != 0 && pairCount != expectedPairCount;
+            expectedPairCount = pairCount;
+
+            char column[32];
+            std::snprintf(column, sizeof(column), "%.3f ms", milliseconds);
+            std::printf(" %-16s", column);
+        }
+        std::printf(" %zu%s\n", expectedPairCount / FRAME_COUNT, isMismatch ? " (MISMATCH)" : "");
+    }
+
+    std::printf("\nAverage ms per region query among %d colliders\n", QUERY_COLLIDER_COUNT);
+    std::printf("%-10s %-16s %-16s boxes per query\n", "region", "aabb tree", "linear pass");
+    const Scene queryScene = MakeScene(QUERY_COLLIDER_COUNT);
+    for (const auto& region : QUERY_REGIONS)
+    {
+        // Centered on the map
+        const AABB box = { (MAP_WIDTH - region.width) / 2.0f, (MAP_HEIGHT - region.height) / 2.0f, (MAP_WIDTH + region.width) / 2.0f, (MAP_HEIGHT + region.height) / 2.0f };
+
+        double treeMilliseconds = 0.0;
+        double linearMilliseconds = 0.0;
+        size_t treeCount = 0;
+        size_t linearCount = 0;
+        MeasureRegionQueries(queryScene, box, treeMilliseconds, linearMilliseconds, treeCount, linearCount);
+
+        char treeColumn[32];
+        std::snprintf(treeColumn, sizeof(treeColumn), "%.4f ms", treeMilliseconds);
+        char linearColumn[32];
+        std::snprintf(linearColumn, sizeof(linearColumn), "%.4f ms", linearMilliseconds);
+        std::printf("%-10s %-16s %-16s %zu%s\n", region.name, treeColumn, linearColumn, linearCount / FRAME_COUNT, treeCount != linearCount ? " (MISMATCH)" : "");
+    }
+    return 0;
+}
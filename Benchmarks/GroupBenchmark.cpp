@@ -0,0 +1,173 @@
+#include "../Source/ECS/ECS.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// GroupBenchmark
+////////////////////////////////////////////////////////////////////////////////
+// Compares views with the owning groups of the movement and render systems.
+// Two registries get the same 100k entities, every component type added in
+// its own shuffled order as after a while of play (60% with a rigidbody, 90%
+// with a sprite); only one of them declares the groups. Each pass is timed
+// alone and the best of 20 is kept. With archetype storage groups are views,
+// so both columns measure the same thing.
+////////////////////////////////////////////////////////////////////////////////
+
+struct Transform
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    float rotation = 0.0f;
+};
+
+struct Rigidbody
+{
+    float velocityX = 0.0f;
+    float velocityY = 0.0f;
+};
+
+struct Sprite
+{
+    int width = 0;
+    int height = 0;
+    int zIndex = 0;
+    bool isFixed = false;
+};
+
+const int ENTITY_COUNT = 100000;
+const int RUN_COUNT = 20;
+const float DELTA_TIME = 1.0f / 60.0f;
+
+template<typename TFunc>
+static double MeasureMilliseconds(TFunc&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename TFunc>
+static double MeasureBestMilliseconds(TFunc&& func)
+{
+    double best = MeasureMilliseconds(func);
+    for (int run = 1; run < RUN_COUNT; run++)
+    {
+        best = std::min(best, MeasureMilliseconds(func));
+    }
+    return best;
+}
+
+// Same seed for both registries, so they hold the same world
+static void Populate(Registry& registry)
+{
+    // The registry logs every component added, which would bury the results
+    std::cout.setstate(std::ios_base::badbit);
+
+    std::mt19937 random(5);
+    std::vector<Entity> entities;
+    for (int i = 0; i < ENTITY_COUNT; i++)
+    {
+        entities.push_back(registry.CreateEntity());
+    }
+
+    std::vector<int> order(ENTITY_COUNT);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), random);
+    for (int i : order)
+    {
+        entities[i].AddComponent<Transform>(Transform{ static_cast<float>(i % 1600), static_cast<float>(i % 1280) });
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    for (int i : order)
+    {
+        if (random() % 10 < 6)
+        {
+            entities[i].AddComponent<Rigidbody>(Rigidbody{ 10.0f, -5.0f });
+        }
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    for (int i : order)
+    {
+        if (random() % 10 < 9)
+        {
+            entities[i].AddComponent<Sprite>(Sprite{ 32, 32, i % 4 });
+        }
+    }
+    registry.Update();
+
+    std::cout.clear();
+}
+
+// The work of MovementSystem and of the culling pass of RenderSystem
+static void Move(const Rigidbody& rigidbody, Transform& transform)
+{
+    transform.x += rigidbody.velocityX * DELTA_TIME;
+    transform.y += rigidbody.velocityY * DELTA_TIME;
+}
+
+static void Cull(const Transform& transform, const Sprite& sprite, int& visibleCount)
+{
+    const bool isOutside = transform.x + transform.scaleX * sprite.width < 0.0f || transform.x > 800.0f ||
+        transform.y + transform.scaleY * sprite.height < 0.0f || transform.y > 600.0f;
+    visibleCount += !isOutside || sprite.isFixed;
+}
+
+int main()
+{
+    Registry viewRegistry;
+    Registry groupRegistry;
+    Populate(viewRegistry);
+    Populate(groupRegistry);
+
+    // As in the game, the render group owns transforms, so the movement group can only observe them
+    groupRegistry.DeclareGroup<const Transform, const Sprite>();
+    groupRegistry.DeclareGroup<const Rigidbody>(Observed<Transform>());
+
+    int visibleCount = 0;
+    const double movementView = MeasureBestMilliseconds([&]()
+    {
+        viewRegistry.View<const Rigidbody, Transform>().Each(Move);
+    });
+    const double movementGroup = MeasureBestMilliseconds([&]()
+    {
+        groupRegistry.Group<const Rigidbody>(Observed<Transform>()).Each(Move);
+    });
+    const double renderView = MeasureBestMilliseconds([&]()
+    {
+        viewRegistry.View<const Transform, const Sprite>().Each([&](const Transform& transform, const Sprite& sprite)
+        {
+            Cull(transform, sprite, visibleCount);
+        });
+    });
+    const double renderGroup = MeasureBestMilliseconds([&]()
+    {
+        groupRegistry.Group<const Transform, const Sprite>().Each([&](const Transform& transform, const Sprite& sprite)
+        {
+            Cull(transform, sprite, visibleCount);
+        });
+    });
+
+    std::printf("%d entities, best of %d passes\n", ENTITY_COUNT, RUN_COUNT);
+    std::printf("%-10s view %6.3f ms | group %6.3f ms\n", "movement", movementView, movementGroup);
+    std::printf("%-10s view %6.3f ms | group %6.3f ms\n", "render", renderView, renderGroup);
+
+    // Printed so the compiler cannot drop the work
+    float checksum = static_cast<float>(visibleCount);
+    viewRegistry.View<const Transform>().Each([&](const Transform& transform)
+    {
+        checksum += transform.x;
+    });
+    groupRegistry.View<const Transform>().Each([&](const Transform& transform)
+    {
+        checksum += transform.x;
+    });
+    std::printf("checksum %g\n", checksum);
+    return 0;
+}
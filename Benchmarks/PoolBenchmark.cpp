@@ -0,0 +1,191 @@
+#include "../Source/ECS/ECS.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// PoolBenchmark
+////////////////////////////////////////////////////////////////////////////////
+// Compares Pool<T>, a sparse set, with the component pool it replaced, which
+// looked entity ids up through two unordered_maps. Both get the same work on
+// 100k entities: add a component to each, read random ones, test random ids
+// (half of them without the component), then remove them all in random order.
+////////////////////////////////////////////////////////////////////////////////
+
+// The pool as it was before the sparse set, kept to measure against
+template<typename T>
+class UnorderedMapPool
+{
+private:
+    std::vector<T> data;
+    int size = 0;
+    std::unordered_map<int, int> entityIdToIndex;
+    std::unordered_map<int, int> indexToEntityId;
+
+public:
+    UnorderedMapPool(int capacity = 100)
+    {
+        data.resize(capacity);
+    }
+
+    bool Has(int entityId) const
+    {
+        return entityIdToIndex.find(entityId) != entityIdToIndex.end();
+    }
+
+    void Set(int entityId, T object)
+    {
+        if (entityIdToIndex.find(entityId) != entityIdToIndex.end())
+        {
+            data[entityIdToIndex[entityId]] = object;
+            return;
+        }
+
+        int index = size;
+        entityIdToIndex.emplace(entityId, index);
+        indexToEntityId.emplace(index, entityId);
+        if (index >= static_cast<int>(data.size()))
+        {
+            data.resize(size * 2);
+        }
+        data[index] = object;
+        size++;
+    }
+
+    void Remove(int entityId)
+    {
+        int indexOfRemoved = entityIdToIndex[entityId];
+        int indexOfLast = size - 1;
+        data[indexOfRemoved] = data[indexOfLast];
+
+        int entityIdOfLastElement = indexToEntityId[indexOfLast];
+        entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;
+        indexToEntityId[indexOfRemoved] = entityIdOfLastElement;
+
+        entityIdToIndex.erase(entityId);
+        indexToEntityId.erase(indexOfLast);
+        size--;
+    }
+
+    T& Get(int entityId)
+    {
+        return data[entityIdToIndex[entityId]];
+    }
+};
+
+struct BenchmarkComponent
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float velocityX = 0.0f;
+    float velocityY = 0.0f;
+};
+
+const int ENTITY_COUNT = 100000;
+const int GET_COUNT = 1000000;
+const int HAS_COUNT = 2000000;
+
+struct BenchmarkTimes
+{
+    double setMilliseconds;
+    double getMilliseconds;
+    double hasMilliseconds;
+    double removeMilliseconds;
+};
+
+template<typename TFunc>
+static double MeasureMilliseconds(TFunc&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename TPool>
+static BenchmarkTimes RunBenchmark(const std::vector<int>& entityIds, const std::vector<int>& removeOrder, const std::vector<int>& lookups,
+    const std::vector<int>& hasLookups, float& checksum)
+{
+    TPool pool;
+    BenchmarkTimes times;
+
+    times.setMilliseconds = MeasureMilliseconds([&]()
+    {
+        for (int entityId : entityIds)
+        {
+            pool.Set(entityId, BenchmarkComponent{ static_cast<float>(entityId), 1.0f, 2.0f, 3.0f });
+        }
+    });
+
+    times.getMilliseconds = MeasureMilliseconds([&]()
+    {
+        for (int entityId : lookups)
+        {
+            checksum += pool.Get(entityId).x;
+        }
+    });
+
+    times.hasMilliseconds = MeasureMilliseconds([&]()
+    {
+        int hasCount = 0;
+        for (int entityId : hasLookups)
+        {
+            hasCount += pool.Has(entityId);
+        }
+        checksum += hasCount;
+    });
+
+    times.removeMilliseconds = MeasureMilliseconds([&]()
+    {
+        for (int entityId : removeOrder)
+        {
+            pool.Remove(entityId);
+        }
+    });
+
+    return times;
+}
+
+static void PrintTimes(const char* name, const BenchmarkTimes& times)
+{
+    std::printf("%-14s Set %7.2f ms | %dM Get %7.2f ms | %dM Has %7.2f ms | Remove %7.2f ms\n", name,
+        times.setMilliseconds, GET_COUNT / 1000000, times.getMilliseconds, HAS_COUNT / 1000000, times.hasMilliseconds,
+        times.removeMilliseconds);
+}
+
+int main()
+{
+    // Entities are added and removed in a shuffled order, as they would be after a while of play
+    std::mt19937 random(1);
+    std::vector<int> entityIds(ENTITY_COUNT);
+    for (int i = 0; i < ENTITY_COUNT; i++)
+    {
+        entityIds[i] = i;
+    }
+    std::shuffle(entityIds.begin(), entityIds.end(), random);
+    std::vector<int> removeOrder = entityIds;
+    std::shuffle(removeOrder.begin(), removeOrder.end(), random);
+
+    std::vector<int> lookups(GET_COUNT);
+    for (int& entityId : lookups)
+    {
+        entityId = random() % ENTITY_COUNT;
+    }
+
+    std::vector<int> hasLookups(HAS_COUNT);
+    for (int& entityId : hasLookups)
+    {
+        entityId = random() % (2 * ENTITY_COUNT);
+    }
+
+    std::printf("%d entities\n", ENTITY_COUNT);
+    float checksum = 0.0f;
+    PrintTimes("unordered_map", RunBenchmark<UnorderedMapPool<BenchmarkComponent>>(entityIds, removeOrder, lookups, hasLookups, checksum));
+    PrintTimes("sparse set", RunBenchmark<Pool<BenchmarkComponent>>(entityIds, removeOrder, lookups, hasLookups, checksum));
+
+    // Printed so the compiler cannot drop the reads
+    std::printf("checksum %g\n", checksum);
+    return 0;
+}
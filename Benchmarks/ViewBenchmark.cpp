@@ -0,0 +1,107 @@
+#include "../Source/ECS/ECS.h"
+#include <chrono>
+#include <cstdio>
+
+////////////////////////////////////////////////////////////////////////////////
+// ViewBenchmark
+////////////////////////////////////////////////////////////////////////////////
+// Compares the two ways a system can walk its components: GetComponent<T>()
+// on every entity of the system, as the systems did before views, and
+// Registry::View<Ts...>().Each(). Both integrate the same 50k moving entities
+// of a 100k entity world, 100 times.
+////////////////////////////////////////////////////////////////////////////////
+
+struct Transform
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float rotation = 0.0f;
+};
+
+struct Rigidbody
+{
+    float velocityX = 0.0f;
+    float velocityY = 0.0f;
+};
+
+class MovingSystem : public System
+{
+public:
+    MovingSystem()
+    {
+        RequireComponent<Transform>();
+        RequireComponent<Rigidbody>();
+    }
+};
+
+const int ENTITY_COUNT = 100000;
+const int BLOCK_SIZE = 500;
+const int PASS_COUNT = 100;
+const float DELTA_TIME = 1.0f / 60.0f;
+
+template<typename TFunc>
+static double MeasureMilliseconds(TFunc&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    // Moving and still entities alternate in blocks, so the pools hold different entities at the same indices
+    Registry registry;
+    registry.AddSystem<MovingSystem>();
+    Prefab moving;
+    moving
+        .AddComponent<Transform>()
+        .AddComponent<Rigidbody>(Rigidbody{ 1.0f, 2.0f });
+    Prefab still;
+    still.AddComponent<Transform>();
+    for (int i = 0; i < ENTITY_COUNT / (2 * BLOCK_SIZE); i++)
+    {
+        registry.Instantiate(moving, BLOCK_SIZE);
+        registry.Instantiate(still, BLOCK_SIZE);
+    }
+    registry.Update();
+
+    const double getComponentMilliseconds = MeasureMilliseconds([&]()
+    {
+        for (int pass = 0; pass < PASS_COUNT; pass++)
+        {
+            for (auto entity : registry.GetSystem<MovingSystem>().GetSystemEntities())
+            {
+                auto& transform = entity.GetComponent<Transform>();
+                const auto& rigidbody = entity.GetComponent<Rigidbody>();
+                transform.x += rigidbody.velocityX * DELTA_TIME;
+                transform.y += rigidbody.velocityY * DELTA_TIME;
+            }
+        }
+    });
+
+    const double viewMilliseconds = MeasureMilliseconds([&]()
+    {
+        for (int pass = 0; pass < PASS_COUNT; pass++)
+        {
+            registry.View<Transform, const Rigidbody>().Each([](Transform& transform, const Rigidbody& rigidbody)
+            {
+                transform.x += rigidbody.velocityX * DELTA_TIME;
+                transform.y += rigidbody.velocityY * DELTA_TIME;
+            });
+        }
+    });
+
+    float checksum = 0.0f;
+    registry.View<const Transform>().Each([&](const Transform& transform)
+    {
+        checksum += transform.x + transform.y;
+    });
+
+    std::printf("%d entities, %d with a rigidbody, %d passes\n", ENTITY_COUNT, ENTITY_COUNT / 2, PASS_COUNT);
+    std::printf("%-30s %7.2f ms\n", "GetComponent over the system", getComponentMilliseconds);
+    std::printf("%-30s %7.2f ms\n", "View<Transform, Rigidbody>", viewMilliseconds);
+
+    // Printed so the compiler cannot drop the writes
+    std::printf("checksum %g\n", checksum);
+    return 0;
+}
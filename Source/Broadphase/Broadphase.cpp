@@ -0,0 +1,35 @@
+#include "Broadphase.h"
+
+static const char* BROADPHASE_TYPE_NAMES[BROADPHASE_TYPE_COUNT] = { "brute_force", "spatial_hash", "sweep_and_prune", "aabb_tree" };
+
+const char* GetBroadphaseTypeName(BroadphaseType type)
+{
+    return type >= 0 && type < BROADPHASE_TYPE_COUNT ? BROADPHASE_TYPE_NAMES[type] : "unknown";
+}
+
+BroadphaseType GetBroadphaseType(const std::string& name)
+{
+    for (int type = 0; type < BROADPHASE_TYPE_COUNT; type++)
+    {
+        if (name == BROADPHASE_TYPE_NAMES[type])
+        {
+            return static_cast<BroadphaseType>(type);
+        }
+    }
+    return BROADPHASE_TYPE_COUNT;
+}
+
+void BruteForceBroadphase::FindPairs(std::span<const AABB> boxes, std::span<const int>, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs)
+{
+    for (int a = 0; a < static_cast<int>(boxes.size()); a++)
+    {
+        const AABB& boxA = boxes[a];
+        for (int b = a + 1; b < static_cast<int>(boxes.size()); b++)
+        {
+            if (ShouldCollide(filters[a], filters[b]) && Overlaps(boxA, boxes[b]))
+            {
+                pairs.push_back({ a, b });
+            }
+        }
+    }
+}
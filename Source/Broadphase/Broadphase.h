@@ -0,0 +1,109 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Broadphase
+////////////////////////////////////////////////////////////////////////////////
+// Types shared by the collision broadphases. A broadphase takes the bounding
+// boxes of the colliders and returns the pairs that may overlap, so only those
+// go through the exact (narrowphase) test. The implementations can be swapped
+// at runtime to compare them on a scene.
+////////////////////////////////////////////////////////////////////////////////
+
+// Axis-aligned bounding box in world space
+struct AABB
+{
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+};
+
+// Edges included, touching boxes are left for the narrowphase to decide
+inline bool Overlaps(const AABB& a, const AABB& b)
+{
+    return a.minX <= b.maxX && a.maxX >= b.minX && a.minY <= b.maxY && a.maxY >= b.minY;
+}
+
+// Collision layer bits of a box
+struct CollisionFilter
+{
+    uint32_t layer;
+    uint32_t mask;
+};
+
+// Two boxes are only paired if each one has a layer of the other in its mask
+inline bool ShouldCollide(const CollisionFilter& a, const CollisionFilter& b)
+{
+    return (a.layer & b.mask) != 0 && (b.layer & a.mask) != 0;
+}
+
+// Indices of two boxes that may overlap, first < second
+struct BroadphasePair
+{
+    int first;
+    int second;
+
+    bool operator <(const BroadphasePair& other) const
+    {
+        return first < other.first || (first == other.first && second < other.second);
+    }
+};
+
+// Cost and output of one broadphase over a frame
+struct BroadphaseStats
+{
+    int colliderCount = 0;
+    int candidatePairCount = 0;
+    int collisionCount = 0;
+    double broadphaseMilliseconds = 0.0;
+    double narrowphaseMilliseconds = 0.0;
+
+    // Broadphase time smoothed over the last frames, the single frame timings are noisy
+    double averageBroadphaseMilliseconds = 0.0;
+};
+
+enum BroadphaseType
+{
+    BROADPHASE_BRUTE_FORCE,
+    BROADPHASE_SPATIAL_HASH,
+    BROADPHASE_SWEEP_AND_PRUNE,
+    BROADPHASE_AABB_TREE,
+    BROADPHASE_TYPE_COUNT
+};
+
+// Name of the type in level files and debug output, e.g. "spatial_hash"
+const char* GetBroadphaseTypeName(BroadphaseType type);
+
+// Type with the given name, or BROADPHASE_TYPE_COUNT if there is none
+BroadphaseType GetBroadphaseType(const std::string& name);
+
+class IBroadphase
+{
+public:
+    virtual ~IBroadphase() = default;
+
+    // Appends each pair of boxes that may overlap and whose filters let them collide, once. keys[i] identifies
+    // boxes[i] from one frame to the next (an entity id), so broadphases that keep state between frames can
+    // follow the boxes. filters[i] is the filter of boxes[i].
+    virtual void FindPairs(std::span<const AABB> boxes, std::span<const int> keys, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// BruteForceBroadphase
+////////////////////////////////////////////////////////////////////////////////
+// Tests every pair of boxes, the reference the other broadphases are measured
+// against.
+////////////////////////////////////////////////////////////////////////////////
+class BruteForceBroadphase : public IBroadphase
+{
+public:
+    void FindPairs(std::span<const AABB> boxes, std::span<const int> keys, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs) override;
+};
+
+#endif
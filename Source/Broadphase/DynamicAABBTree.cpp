@@ -0,0 +1,328 @@
+#include "DynamicAABBTree.h"
+#include <algorithm>
+
+static AABB Union(const AABB& a, const AABB& b)
+{
+    return { std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY) };
+}
+
+static float Perimeter(const AABB& box)
+{
+    return 2.0f * ((box.maxX - box.minX) + (box.maxY - box.minY));
+}
+
+static bool Contains(const AABB& outer, const AABB& inner)
+{
+    return outer.minX <= inner.minX && outer.minY <= inner.minY && outer.maxX >= inner.maxX && outer.maxY >= inner.maxY;
+}
+
+int DynamicAABBTree::AllocateNode()
+{
+    if (firstFreeNode == NULL_NODE)
+    {
+        nodes.emplace_back();
+        firstFreeNode = static_cast<int>(nodes.size()) - 1;
+        nodes[firstFreeNode].parent = NULL_NODE;
+    }
+
+    const int node = firstFreeNode;
+    firstFreeNode = nodes[node].parent;
+    nodes[node].parent = NULL_NODE;
+    nodes[node].child1 = NULL_NODE;
+    nodes[node].child2 = NULL_NODE;
+    nodes[node].height = 0;
+    nodes[node].key = -1;
+    nodes[node].boxIndex = -1;
+    nodeCount++;
+    return node;
+}
+
+void DynamicAABBTree::FreeNode(int node)
+{
+    nodes[node].parent = firstFreeNode;
+    nodes[node].height = -1;
+    firstFreeNode = node;
+    nodeCount--;
+}
+
+void DynamicAABBTree::SetFatMargin(float margin)
+{
+    fatMargin = std::max(margin, 0.0f);
+}
+
+AABB DynamicAABBTree::GetFatBox(const AABB& box, float displacementX, float displacementY) const
+{
+    AABB fatBox = { box.minX - fatMargin, box.minY - fatMargin, box.maxX + fatMargin, box.maxY + fatMargin };
+
+    // Teleports would leave a huge fat box behind, the stretch is capped
+    const float maxStretch = 4.0f * fatMargin;
+    const float stretchX = std::clamp(displacementX * DISPLACEMENT_MULTIPLIER, -maxStretch, maxStretch);
+    const float stretchY = std::clamp(displacementY * DISPLACEMENT_MULTIPLIER, -maxStretch, maxStretch);
+    (stretchX < 0.0f ? fatBox.minX : fatBox.maxX) += stretchX;
+    (stretchY < 0.0f ? fatBox.minY : fatBox.maxY) += stretchY;
+    return fatBox;
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf)
+{
+    if (root == NULL_NODE)
+    {
+        root = leaf;
+        nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Walk down towards the sibling whose box grows the least, costs being perimeters
+    const AABB leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        const Node& node = nodes[index];
+        const float perimeter = Perimeter(node.box);
+        const float combinedPerimeter = Perimeter(Union(node.box, leafBox));
+
+        // Cost of pairing the leaf with this node, and the growth every deeper choice inherits
+        const float cost = 2.0f * combinedPerimeter;
+        const float inheritedCost = 2.0f * (combinedPerimeter - perimeter);
+
+        auto getDescendCost = [&](int child)
+        {
+            const AABB& childBox = nodes[child].box;
+            const float grownPerimeter = Perimeter(Union(childBox, leafBox));
+            return (nodes[child].IsLeaf() ? grownPerimeter : grownPerimeter - Perimeter(childBox)) + inheritedCost;
+        };
+        const float cost1 = getDescendCost(node.child1);
+        const float cost2 = getDescendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+        {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+    const int sibling = index;
+
+    // A new parent takes the place of the sibling, with the sibling and the leaf as children
+    const int oldParent = nodes[sibling].parent;
+    const int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = Union(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+    if (oldParent == NULL_NODE)
+    {
+        root = newParent;
+    }
+    else if (nodes[oldParent].child1 == sibling)
+    {
+        nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    // Fix the heights and boxes of the ancestors, balancing on the way
+    for (index = nodes[leaf].parent; index != NULL_NODE; index = nodes[index].parent)
+    {
+        index = Balance(index);
+        Node& node = nodes[index];
+        node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+        node.box = Union(nodes[node.child1].box, nodes[node.child2].box);
+    }
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root)
+    {
+        root = NULL_NODE;
+        return;
+    }
+
+    // The sibling takes the place of the parent, which goes away
+    const int parent = nodes[leaf].parent;
+    const int grandParent = nodes[parent].parent;
+    const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    FreeNode(parent);
+
+    nodes[sibling].parent = grandParent;
+    if (grandParent == NULL_NODE)
+    {
+        root = sibling;
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent)
+    {
+        nodes[grandParent].child1 = sibling;
+    }
+    else
+    {
+        nodes[grandParent].child2 = sibling;
+    }
+
+    for (int index = grandParent; index != NULL_NODE; index = nodes[index].parent)
+    {
+        index = Balance(index);
+        Node& node = nodes[index];
+        node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+        node.box = Union(nodes[node.child1].box, nodes[node.child2].box);
+    }
+}
+
+int DynamicAABBTree::Balance(int iA)
+{
+    Node& a = nodes[iA];
+    if (a.IsLeaf() || a.height < 2)
+    {
+        return iA;
+    }
+
+    const int iB = a.child1;
+    const int iC = a.child2;
+    Node& b = nodes[iB];
+    Node& c = nodes[iC];
+    const int balance = c.height - b.height;
+    if (balance >= -1 && balance <= 1)
+    {
+        return iA;
+    }
+
+    // The taller child (up) takes the place of A, A keeps the shorter child and the shorter grandchild
+    // of up, and up keeps A and its taller child
+    const bool isRightHeavy = balance > 1;
+    const int iUp = isRightHeavy ? iC : iB;
+    Node& up = nodes[iUp];
+    const int iF = up.child1;
+    const int iG = up.child2;
+    Node& f = nodes[iF];
+    Node& g = nodes[iG];
+
+    up.child1 = iA;
+    up.parent = a.parent;
+    a.parent = iUp;
+    if (up.parent == NULL_NODE)
+    {
+        root = iUp;
+    }
+    else if (nodes[up.parent].child1 == iA)
+    {
+        nodes[up.parent].child1 = iUp;
+    }
+    else
+    {
+        nodes[up.parent].child2 = iUp;
+    }
+
+    const int iTaller = f.height > g.height ? iF : iG;
+    const int iShorter = f.height > g.height ? iG : iF;
+    up.child2 = iTaller;
+    nodes[iShorter].parent = iA;
+    if (isRightHeavy)
+    {
+        a.child2 = iShorter;
+    }
+    else
+    {
+        a.child1 = iShorter;
+    }
+
+    a.box = Union(nodes[a.child1].box, nodes[a.child2].box);
+    a.height = 1 + std::max(nodes[a.child1].height, nodes[a.child2].height);
+    up.box = Union(a.box, nodes[iTaller].box);
+    up.height = 1 + std::max(a.height, nodes[iTaller].height);
+
+    rotationCount++;
+    return iUp;
+}
+
+void DynamicAABBTree::Update(std::span<const AABB> boxes, std::span<const int> keys)
+{
+    frame++;
+    refitCount = 0;
+    rotationCount = 0;
+
+    for (int key : keys)
+    {
+        if (key >= static_cast<int>(slots.size()))
+        {
+            slots.resize(key + 1);
+        }
+        slots[key].frame = frame;
+    }
+
+    // Leaves of the keys that are gone
+    size_t keptCount = 0;
+    for (int key : keysInTree)
+    {
+        KeySlot& slot = slots[key];
+        if (slot.frame != frame)
+        {
+            RemoveLeaf(slot.leaf);
+            FreeNode(slot.leaf);
+            slot.leaf = NULL_NODE;
+            continue;
+        }
+        keysInTree[keptCount++] = key;
+    }
+    keysInTree.resize(keptCount);
+
+    for (int boxIndex = 0; boxIndex < static_cast<int>(boxes.size()); boxIndex++)
+    {
+        const AABB& box = boxes[boxIndex];
+        KeySlot& slot = slots[keys[boxIndex]];
+        if (slot.leaf == NULL_NODE)
+        {
+            slot.leaf = AllocateNode();
+            nodes[slot.leaf].key = keys[boxIndex];
+            nodes[slot.leaf].box = GetFatBox(box, 0.0f, 0.0f);
+            InsertLeaf(slot.leaf);
+            keysInTree.push_back(keys[boxIndex]);
+        }
+        else if (!Contains(nodes[slot.leaf].box, box))
+        {
+            const AABB& previousBox = nodes[slot.leaf].tightBox;
+            RemoveLeaf(slot.leaf);
+            nodes[slot.leaf].box = GetFatBox(box, box.minX - previousBox.minX, box.minY - previousBox.minY);
+            InsertLeaf(slot.leaf);
+            refitCount++;
+        }
+
+        nodes[slot.leaf].tightBox = box;
+        nodes[slot.leaf].boxIndex = boxIndex;
+    }
+}
+
+void DynamicAABBTree::FindPairs(std::span<const AABB> boxes, std::span<const int> keys, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs)
+{
+    Update(boxes, keys);
+
+    // Every pair is met from both of its boxes, the lower index reports it
+    for (int boxIndex = 0; boxIndex < static_cast<int>(boxes.size()); boxIndex++)
+    {
+        const AABB& box = boxes[boxIndex];
+        QueryLeaves(box, queryStack, [&](int leaf)
+        {
+            const Node& node = nodes[leaf];
+            if (node.boxIndex > boxIndex && ShouldCollide(filters[boxIndex], filters[node.boxIndex]) && Overlaps(node.tightBox, box))
+            {
+                pairs.push_back({ boxIndex, node.boxIndex });
+            }
+        });
+    }
+}
+
+AABBTreeStats DynamicAABBTree::GetStats() const
+{
+    AABBTreeStats stats;
+    stats.nodeCount = nodeCount;
+    stats.leafCount = static_cast<int>(keysInTree.size());
+    stats.height = root == NULL_NODE ? 0 : nodes[root].height;
+    stats.refitCount = refitCount;
+    stats.rotationCount = rotationCount;
+    return stats;
+}
@@ -0,0 +1,170 @@
+#ifndef DYNAMICAABBTREE_H
+#define DYNAMICAABBTREE_H
+
+#include "Broadphase.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// DynamicAABBTree
+////////////////////////////////////////////////////////////////////////////////
+// Bounding volume hierarchy over the collider boxes, kept from frame to frame.
+// Every leaf holds a fat box, the collider box grown by a margin and stretched
+// along its last displacement, so a moving collider is only re-inserted (a
+// refit) when it leaves its fat box. Inserting picks the sibling with the
+// cheapest perimeter growth, and AVL rotations on the way up keep the tree
+// balanced, so queries stay logarithmic. Besides pair generation the tree
+// answers region queries, e.g. for culling.
+////////////////////////////////////////////////////////////////////////////////
+struct AABBTreeStats
+{
+    int nodeCount = 0;
+    int leafCount = 0;
+    int height = 0;
+
+    // Leaves re-inserted and rotations done by the last Update()
+    int refitCount = 0;
+    int rotationCount = 0;
+};
+
+class DynamicAABBTree : public IBroadphase
+{
+private:
+    static constexpr int NULL_NODE = -1;
+
+    struct Node
+    {
+        // Fat box for leaves, union of the children for internal nodes
+        AABB box;
+
+        // Leaves only: the collider box, and where it was in the boxes given to the last Update()
+        AABB tightBox;
+        int key;
+        int boxIndex;
+
+        // Next free node while the node is unused
+        int parent;
+        int child1;
+        int child2;
+
+        // Leaves are at height 0, free nodes at -1
+        int height;
+
+        bool IsLeaf() const
+        {
+            return child1 == NULL_NODE;
+        }
+    };
+
+    struct KeySlot
+    {
+        int leaf = NULL_NODE;
+        uint32_t frame = 0;
+    };
+
+    std::vector<Node> nodes;
+    int root = NULL_NODE;
+    int firstFreeNode = NULL_NODE;
+    int nodeCount = 0;
+
+    // [Vector index = box key]
+    std::vector<KeySlot> slots;
+    std::vector<int> keysInTree;
+    uint32_t frame = 0;
+
+    float fatMargin = DEFAULT_FAT_MARGIN;
+    int refitCount = 0;
+    int rotationCount = 0;
+
+    // Reused by FindPairs() for its queries
+    std::vector<int> queryStack;
+
+    int AllocateNode();
+
+    void FreeNode(int node);
+
+    // Fat box of a leaf holding box, stretched along the displacement since it was last inserted
+    AABB GetFatBox(const AABB& box, float displacementX, float displacementY) const;
+
+    void InsertLeaf(int leaf);
+
+    void RemoveLeaf(int leaf);
+
+    // Rotates the subtree of node if its children heights differ by more than one, returns the new subtree root
+    int Balance(int node);
+
+    // Calls func(node) for every leaf whose fat box overlaps the region
+    template<typename TFunc>
+    void QueryLeaves(const AABB& region, std::vector<int>& stack, TFunc&& func) const;
+
+public:
+    // Pixels added around every collider box
+    static constexpr float DEFAULT_FAT_MARGIN = 8.0f;
+
+    // Fraction of the displacement the fat box is stretched by, ahead of the collider
+    static constexpr float DISPLACEMENT_MULTIPLIER = 2.0f;
+
+    void SetFatMargin(float margin);
+
+    // Brings the tree in line with the boxes: new keys are inserted, missing keys removed, and boxes that left
+    // their fat box re-inserted. Keys must be non-negative and unique within a frame.
+    void Update(std::span<const AABB> boxes, std::span<const int> keys);
+
+    // Calls func(boxIndex, key) for every box of the last Update() that overlaps the region, edges included
+    template<typename TFunc>
+    void Query(const AABB& region, TFunc&& func) const;
+
+    void FindPairs(std::span<const AABB> boxes, std::span<const int> keys, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs) override;
+
+    AABBTreeStats GetStats() const;
+};
+
+template<typename TFunc>
+void DynamicAABBTree::QueryLeaves(const AABB& region, std::vector<int>& stack, TFunc&& func) const
+{
+    if (root == NULL_NODE)
+    {
+        return;
+    }
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        const int index = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[index];
+        if (!Overlaps(node.box, region))
+        {
+            continue;
+        }
+
+        if (node.IsLeaf())
+        {
+            func(index);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+template<typename TFunc>
+void DynamicAABBTree::Query(const AABB& region, TFunc&& func) const
+{
+    std::vector<int> stack;
+    QueryLeaves(region, stack, [&](int leaf)
+    {
+        const Node& node = nodes[leaf];
+        if (Overlaps(node.tightBox, region))
+        {
+            func(node.boxIndex, node.key);
+        }
+    });
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+// Cell coordinates are clamped, so boxes far outside the map (projectiles flying away) cannot overflow them
+static const float MAX_CELL_COORDINATE = 1 << 30;
+
+static unsigned int HashCell(int cellX, int cellY)
+{
+    return (static_cast<unsigned int>(cellX) * 73856093u) ^ (static_cast<unsigned int>(cellY) * 19349663u);
+}
+
+SpatialHashGrid::SpatialHashGrid(float cellSize) : cellSize(DEFAULT_CELL_SIZE), inverseCellSize(1.0f / DEFAULT_CELL_SIZE)
+{
+    SetCellSize(cellSize);
+}
+
+void SpatialHashGrid::SetCellSize(float cellSize)
+{
+    if (cellSize > 0.0f)
+    {
+        this->cellSize = cellSize;
+        inverseCellSize = 1.0f / cellSize;
+    }
+}
+
+float SpatialHashGrid::GetCellSize() const
+{
+    return cellSize;
+}
+
+int SpatialHashGrid::GetCell(float coordinate) const
+{
+    return static_cast<int>(std::clamp(std::floor(coordinate * inverseCellSize), -MAX_CELL_COORDINATE, MAX_CELL_COORDINATE));
+}
+
+void SpatialHashGrid::FindPairs(std::span<const AABB> boxes, std::span<const int>, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs)
+{
+    entries.clear();
+    oversizedBoxes.clear();
+
+    for (int boxIndex = 0; boxIndex < static_cast<int>(boxes.size()); boxIndex++)
+    {
+        const AABB& box = boxes[boxIndex];
+        const int minCellX = GetCell(box.minX);
+        const int minCellY = GetCell(box.minY);
+        const int maxCellX = GetCell(box.maxX);
+        const int maxCellY = GetCell(box.maxY);
+
+        const int64_t cellCount = (int64_t(maxCellX) - minCellX + 1) * (int64_t(maxCellY) - minCellY + 1);
+        if (cellCount > MAX_CELLS_PER_BOX)
+        {
+            oversizedBoxes.push_back(boxIndex);
+            continue;
+        }
+
+        for (int cellY = minCellY; cellY <= maxCellY; cellY++)
+        {
+            for (int cellX = minCellX; cellX <= maxCellX; cellX++)
+            {
+                entries.push_back({ cellX, cellY, boxIndex });
+            }
+        }
+    }
+
+    // Counting sort of the entries by hash bucket, with about two buckets per entry.
+    // The counts are turned into bucket ends, and filling each bucket backwards leaves its start behind.
+    const unsigned int bucketCount = std::bit_ceil(std::max<size_t>(entries.size() * 2, 1));
+    const unsigned int bucketMask = bucketCount - 1;
+    bucketStarts.assign(bucketCount + 1, 0);
+    for (const CellEntry& entry : entries)
+    {
+        bucketStarts[HashCell(entry.cellX, entry.cellY) & bucketMask]++;
+    }
+    int bucketEnd = 0;
+    for (unsigned int bucket = 0; bucket < bucketCount; bucket++)
+    {
+        bucketEnd += bucketStarts[bucket];
+        bucketStarts[bucket] = bucketEnd;
+    }
+    bucketStarts[bucketCount] = bucketEnd;
+
+    sortedEntries.resize(entries.size());
+    for (auto entry = entries.rbegin(); entry != entries.rend(); entry++)
+    {
+        sortedEntries[--bucketStarts[HashCell(entry->cellX, entry->cellY) & bucketMask]] = *entry;
+    }
+
+    for (unsigned int bucket = 0; bucket < bucketCount; bucket++)
+    {
+        const int end = bucketStarts[bucket + 1];
+        for (int i = bucketStarts[bucket]; i < end; i++)
+        {
+            const CellEntry& a = sortedEntries[i];
+            for (int j = i + 1; j < end; j++)
+            {
+                const CellEntry& b = sortedEntries[j];
+
+                // Other cells may hash to the same bucket
+                if (a.cellX != b.cellX || a.cellY != b.cellY)
+                {
+                    continue;
+                }
+
+                if (!ShouldCollide(filters[a.boxIndex], filters[b.boxIndex]))
+                {
+                    continue;
+                }
+
+                // Sharing a cell does not mean touching, and touching pairs are reported from one of their cells only
+                const AABB& boxA = boxes[a.boxIndex];
+                const AABB& boxB = boxes[b.boxIndex];
+                if (!Overlaps(boxA, boxB))
+                {
+                    continue;
+                }
+                if (GetCell(std::max(boxA.minX, boxB.minX)) != a.cellX || GetCell(std::max(boxA.minY, boxB.minY)) != a.cellY)
+                {
+                    continue;
+                }
+
+                pairs.push_back({ std::min(a.boxIndex, b.boxIndex), std::max(a.boxIndex, b.boxIndex) });
+            }
+        }
+    }
+
+    // Oversized boxes are paired with every box they touch, a pair of them from the lower index only
+    for (int a : oversizedBoxes)
+    {
+        const AABB& boxA = boxes[a];
+        for (int b = 0; b < static_cast<int>(boxes.size()); b++)
+        {
+            if (b == a || (b < a && std::binary_search(oversizedBoxes.begin(), oversizedBoxes.end(), b)))
+            {
+                continue;
+            }
+
+            if (ShouldCollide(filters[a], filters[b]) && Overlaps(boxA, boxes[b]))
+            {
+                pairs.push_back({ std::min(a, b), std::max(a, b) });
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef SPATIALHASHGRID_H
+#define SPATIALHASHGRID_H
+
+#include "Broadphase.h"
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// SpatialHashGrid
+////////////////////////////////////////////////////////////////////////////////
+// Uniform grid broadphase. Every box is entered in the cells it covers, the
+// cells being hashed into a table that is rebuilt each frame with a counting
+// sort, and boxes are only tested against the boxes sharing one of their cells.
+// A pair sharing several cells is reported from one of them only: the cell of
+// the top-left corner of the boxes' intersection, which both of them cover.
+// The cell size should be about the size of the common colliders.
+////////////////////////////////////////////////////////////////////////////////
+class SpatialHashGrid : public IBroadphase
+{
+private:
+    struct CellEntry
+    {
+        int cellX;
+        int cellY;
+        int boxIndex;
+    };
+
+    float cellSize;
+    float inverseCellSize;
+
+    // Cell entries in insertion order, then grouped by hash bucket
+    std::vector<CellEntry> entries;
+    std::vector<CellEntry> sortedEntries;
+
+    // [Vector index = hash bucket] [Value = first index of the bucket in sortedEntries]
+    std::vector<int> bucketStarts;
+
+    // Boxes covering too many cells to be entered in the grid, they are tested against every box
+    std::vector<int> oversizedBoxes;
+
+    int GetCell(float coordinate) const;
+
+public:
+    static constexpr float DEFAULT_CELL_SIZE = 64.0f;
+
+    // A box covering more cells than this is paired by brute force instead
+    static constexpr int MAX_CELLS_PER_BOX = 64;
+
+    explicit SpatialHashGrid(float cellSize = DEFAULT_CELL_SIZE);
+
+    // Sizes that are not positive are ignored
+    void SetCellSize(float cellSize);
+
+    float GetCellSize() const;
+
+    // Rebuilds the grid from the boxes and appends each pair of boxes that touch, edges included, once.
+    // The grid keeps nothing from one frame to the next, so the keys are not needed.
+    void FindPairs(std::span<const AABB> boxes, std::span<const int> keys, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs) override;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+void SweepAndPrune::FindPairs(std::span<const AABB> boxes, std::span<const int> keys, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs)
+{
+    frame++;
+    for (int boxIndex = 0; boxIndex < static_cast<int>(boxes.size()); boxIndex++)
+    {
+        const int key = keys[boxIndex];
+        if (key >= static_cast<int>(slots.size()))
+        {
+            slots.resize(key + 1);
+        }
+        slots[key].boxIndex = boxIndex;
+        slots[key].frame = frame;
+    }
+
+    // Move the endpoints of the boxes still there to their new values, and drop the others
+    size_t keptCount = 0;
+    for (const Endpoint& endpoint : endpoints)
+    {
+        KeySlot& slot = slots[endpoint.keyAndSide >> 1];
+        if (slot.frame != frame)
+        {
+            slot.hasEndpoints = false;
+            continue;
+        }
+
+        const AABB& box = boxes[slot.boxIndex];
+        const bool isMin = endpoint.keyAndSide & 1;
+        endpoints[keptCount++] = { isMin ? box.minX : box.maxX, endpoint.keyAndSide };
+    }
+    endpoints.resize(keptCount);
+
+    // Insertion sort, each endpoint only travels past the neighbours its box crossed since the last frame
+    for (size_t i = 1; i < endpoints.size(); i++)
+    {
+        const Endpoint endpoint = endpoints[i];
+        size_t j = i;
+        while (j > 0 && IsBefore(endpoint, endpoints[j - 1]))
+        {
+            endpoints[j] = endpoints[j - 1];
+            j--;
+        }
+        endpoints[j] = endpoint;
+    }
+
+    // New boxes are sorted on their own and merged in, so a burst of spawns does not go through the insertion sort
+    for (int boxIndex = 0; boxIndex < static_cast<int>(boxes.size()); boxIndex++)
+    {
+        KeySlot& slot = slots[keys[boxIndex]];
+        if (!slot.hasEndpoints)
+        {
+            slot.hasEndpoints = true;
+            endpoints.push_back({ boxes[boxIndex].minX, keys[boxIndex] << 1 | 1 });
+            endpoints.push_back({ boxes[boxIndex].maxX, keys[boxIndex] << 1 });
+        }
+    }
+    if (endpoints.size() > keptCount)
+    {
+        std::sort(endpoints.begin() + keptCount, endpoints.end(), IsBefore);
+        std::inplace_merge(endpoints.begin(), endpoints.begin() + keptCount, endpoints.end(), IsBefore);
+    }
+
+    // Sweep along x, a box overlaps in x every box that is open when its min endpoint is reached
+    openBoxes.clear();
+    openBoxPositions.resize(boxes.size());
+    for (const Endpoint& endpoint : endpoints)
+    {
+        const int boxIndex = slots[endpoint.keyAndSide >> 1].boxIndex;
+        if (!(endpoint.keyAndSide & 1))
+        {
+            const int position = openBoxPositions[boxIndex];
+            openBoxes[position] = openBoxes.back();
+            openBoxPositions[openBoxes[position]] = position;
+            openBoxes.pop_back();
+            continue;
+        }
+
+        const AABB& box = boxes[boxIndex];
+        for (int openBox : openBoxes)
+        {
+            const AABB& other = boxes[openBox];
+            if (box.minY <= other.maxY && box.maxY >= other.minY && ShouldCollide(filters[boxIndex], filters[openBox]))
+            {
+                pairs.push_back({ std::min(boxIndex, openBox), std::max(boxIndex, openBox) });
+            }
+        }
+        openBoxPositions[boxIndex] = static_cast<int>(openBoxes.size());
+        openBoxes.push_back(boxIndex);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include "Broadphase.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// SweepAndPrune
+////////////////////////////////////////////////////////////////////////////////
+// Keeps the min and max x endpoints of every box in one sorted list that lives
+// from frame to frame. Boxes only move a few pixels per frame, so each frame the
+// endpoints are updated in place and an insertion sort puts the few that
+// crossed a neighbour back in order, in close to linear time. A sweep along the
+// list then pairs every box with the boxes open at its min endpoint whose y
+// extents overlap.
+////////////////////////////////////////////////////////////////////////////////
+class SweepAndPrune : public IBroadphase
+{
+private:
+    struct Endpoint
+    {
+        float value;
+
+        // Key of the box shifted left once, with the low bit set on min endpoints
+        int keyAndSide;
+    };
+
+    struct KeySlot
+    {
+        // Index of the box in the current frame, valid when frame is the current frame
+        int boxIndex = -1;
+        uint32_t frame = 0;
+        bool hasEndpoints = false;
+    };
+
+    // Endpoints of all boxes sorted along x, min before max at equal values
+    std::vector<Endpoint> endpoints;
+
+    // [Vector index = box key]
+    std::vector<KeySlot> slots;
+    uint32_t frame = 0;
+
+    // Boxes whose min endpoint was swept and max endpoint was not yet
+    std::vector<int> openBoxes;
+    // [Vector index = box index] [Value = position in openBoxes]
+    std::vector<int> openBoxPositions;
+
+    static bool IsBefore(const Endpoint& a, const Endpoint& b)
+    {
+        return a.value < b.value || (a.value == b.value && (a.keyAndSide & 1) > (b.keyAndSide & 1));
+    }
+
+public:
+    // Keys must be non-negative and unique within a frame
+    void FindPairs(std::span<const AABB> boxes, std::span<const int> keys, std::span<const CollisionFilter> filters, std::vector<BroadphasePair>& pairs) override;
+};
+
+#endif
@@ -1,10 +1,13 @@
 #ifndef ANIMATIONCOMPONENT_H
 #define ANIMATIONCOMPONENT_H
 
+#include "ComponentIds.h"
 #include "SDL.h"
 
 struct AnimationComponent 
 {
+    static constexpr int componentId = COMPONENT_ID_ANIMATION;
+
     int numFrames;
     int currentFrame;
     int frameSpeedRate;
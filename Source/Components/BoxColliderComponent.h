@@ -1,19 +1,40 @@
 #ifndef BOXCOLLIDERCOMPONENT_H
 #define BOXCOLLIDERCOMPONENT_H
 
+#include "ComponentIds.h"
 #include "glm/glm.hpp"
+#include <cstdint>
+
+// Collision layer bits. Two colliders collide only if each one has a layer of the other in its mask.
+enum CollisionLayer : uint32_t
+{
+	COLLISION_LAYER_DEFAULT = 1u << 0,
+	COLLISION_LAYER_PLAYER = 1u << 1,
+	COLLISION_LAYER_ENEMIES = 1u << 2,
+	COLLISION_LAYER_PROJECTILES = 1u << 3,
+	COLLISION_LAYER_OBSTACLES = 1u << 4,
+	COLLISION_LAYER_ALL = 0xFFFFFFFFu
+};
 
 struct BoxColliderComponent 
 {
+	static constexpr int componentId = COMPONENT_ID_BOX_COLLIDER;
+
 	int width;
 	int height;
 	glm::vec2 offset;
 
-	BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0, 0))
+	// Layers the collider is in, and layers it collides with
+	uint32_t layer;
+	uint32_t mask;
+
+	BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0, 0), uint32_t layer = COLLISION_LAYER_DEFAULT, uint32_t mask = COLLISION_LAYER_ALL)
 	{
 		this->width = width;
 		this->height = height;
 		this->offset = offset;
+		this->layer = layer;
+		this->mask = mask;
 	}
 };
 
@@ -1,8 +1,12 @@
 #ifndef CAMERAFOLLOWCOMPONENT_H
 #define CAMERAFOLLOWCOMPONENT_H
 
+#include "ComponentIds.h"
+
 struct CameraFollowComponent
 {
+    static constexpr int componentId = COMPONENT_ID_CAMERA_FOLLOW;
+
     CameraFollowComponent() = default;
 };
 
@@ -0,0 +1,21 @@
+#ifndef COMPONENTIDS_H
+#define COMPONENTIDS_H
+
+// Compile-time ids of the game components, see Component<T>::GetId(). They all come from this one list so no two
+// components can share an id, and with it a component pool. Ids must stay below STATIC_COMPONENT_ID_COUNT.
+enum ComponentId
+{
+	COMPONENT_ID_TRANSFORM,
+	COMPONENT_ID_RIGIDBODY,
+	COMPONENT_ID_SPRITE,
+	COMPONENT_ID_ANIMATION,
+	COMPONENT_ID_BOX_COLLIDER,
+	COMPONENT_ID_KEYBOARD_CONTROL,
+	COMPONENT_ID_CAMERA_FOLLOW,
+	COMPONENT_ID_PROJECTILE_EMITTER,
+	COMPONENT_ID_HEALTH,
+	COMPONENT_ID_PROJECTILE,
+	COMPONENT_ID_TEXT_LABEL
+};
+
+#endif
@@ -1,8 +1,12 @@
 #ifndef HEALTHCOMPONENT_H
 #define HEALTHCOMPONENT_H
 
+#include "ComponentIds.h"
+
 struct HealthComponent
 {
+    static constexpr int componentId = COMPONENT_ID_HEALTH;
+
     int healthPercentage;
 
     HealthComponent(int healthPercentage = 0)
@@ -1,10 +1,13 @@
 #ifndef KEYBOARDCONTROLCOMPONENT_H
 #define KEYBOARDCONTROLCOMPONENT_H
 
+#include "ComponentIds.h"
 #include <glm/glm.hpp>
 
 struct KeyboardControlComponent
 {
+	static constexpr int componentId = COMPONENT_ID_KEYBOARD_CONTROL;
+
 	glm::vec2 upVelocity;
 	glm::vec2 rightVelocity;
 	glm::vec2 downVelocity;
@@ -1,10 +1,13 @@
 #ifndef PROJECTILECOMPONENT_H
 #define PROJECTILECOMPONENT_H
 
+#include "ComponentIds.h"
 #include "SDL.h"
 
 struct ProjectileComponent
 {
+    static constexpr int componentId = COMPONENT_ID_PROJECTILE;
+
     bool isFriendly;
     int hitPercentDamage;
     int duration;
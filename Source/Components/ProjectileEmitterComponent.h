@@ -1,11 +1,14 @@
 #ifndef PROJECTILEEMITTERCOMPONENT_H
 #define PROJECTILEEMITTERCOMPONENT_H
 
+#include "ComponentIds.h"
 #include "SDL.h"
 #include "glm/glm.hpp"
 
 struct ProjectileEmitterComponent
 {
+    static constexpr int componentId = COMPONENT_ID_PROJECTILE_EMITTER;
+
     glm::vec2 projectileVelocity;
     int repeatFrequency;
     int projectileDuration;
@@ -1,10 +1,13 @@
 #ifndef RIGIDBODYCOMPONENT_H
 #define RIGIDBODYCOMPONENT_H
 
+#include "ComponentIds.h"
 #include <glm/glm.hpp>
 
 struct RigidbodyComponent
 {
+	static constexpr int componentId = COMPONENT_ID_RIGIDBODY;
+
 	glm::vec2 velocity;
 
 	RigidbodyComponent(glm::vec2 velocity = glm::vec2(0.0f, 0.0f))
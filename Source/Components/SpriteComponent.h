@@ -1,11 +1,14 @@
 #ifndef SPRITECOMPONENT_H
 #define SPRITECOMPONENT_H
 
+#include "ComponentIds.h"
 #include <string>
 #include "SDL.h"
 
 struct SpriteComponent 
 {
+    static constexpr int componentId = COMPONENT_ID_SPRITE;
+
     std::string assetId;
     int width;
     int height;
@@ -24,6 +27,31 @@ struct SpriteComponent
         this->flip = SDL_FLIP_NONE;
         this->srcRect = { srcRectX, srcRectY, width, height };
     }
+
+    // Registry snapshot hooks, the asset id string keeps the component from being copied as raw bytes
+    template<typename TWriter>
+    void Serialize(TWriter& writer) const
+    {
+        writer.Write(assetId);
+        writer.Write(width);
+        writer.Write(height);
+        writer.Write(zIndex);
+        writer.Write(isFixed);
+        writer.Write(flip);
+        writer.Write(srcRect);
+    }
+
+    template<typename TReader>
+    void Deserialize(TReader& reader)
+    {
+        reader.Read(assetId);
+        reader.Read(width);
+        reader.Read(height);
+        reader.Read(zIndex);
+        reader.Read(isFixed);
+        reader.Read(flip);
+        reader.Read(srcRect);
+    }
 };
 
 #endif
\ No newline at end of file
@@ -1,12 +1,15 @@
 #ifndef TEXTLABELCOMPONENT_H
 #define TEXTLABELCOMPONENT_H
 
+#include "ComponentIds.h"
 #include "glm/glm.hpp"
 #include <string>
 #include "SDL.h"
 
 struct TextLabelComponent
 {
+    static constexpr int componentId = COMPONENT_ID_TEXT_LABEL;
+
     glm::vec2 position;
     std::string text;
     std::string assetId;
@@ -21,6 +24,27 @@ struct TextLabelComponent
         this->color = color;
         this->isFixed = isFixed;
     }
+
+    // Registry snapshot hooks, the strings keep the component from being copied as raw bytes
+    template<typename TWriter>
+    void Serialize(TWriter& writer) const
+    {
+        writer.Write(position);
+        writer.Write(text);
+        writer.Write(assetId);
+        writer.Write(color);
+        writer.Write(isFixed);
+    }
+
+    template<typename TReader>
+    void Deserialize(TReader& reader)
+    {
+        reader.Read(position);
+        reader.Read(text);
+        reader.Read(assetId);
+        reader.Read(color);
+        reader.Read(isFixed);
+    }
 };
 
 #endif
\ No newline at end of file
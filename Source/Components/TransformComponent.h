@@ -1,10 +1,13 @@
 #ifndef TRANSFORMCOMPONENT_H
 #define TRANSFORMCOMPONENT_H
 
+#include "ComponentIds.h"
 #include "glm/glm.hpp"
 
 struct TransformComponent
 {
+	static constexpr int componentId = COMPONENT_ID_TRANSFORM;
+
 	glm::vec2 position;
 	glm::vec2 scale;
 	double rotation;
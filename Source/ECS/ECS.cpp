@@ -1,14 +1,53 @@
 #include "ECS.h"
 #include "../Logger/Logger.h"
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
 
-int IComponent::nextId = 0;
+int IComponent::nextId = STATIC_COMPONENT_ID_COUNT;
+
+std::string IComponent::DemangleTypeName(const char* name)
+{
+#ifdef __GNUG__
+    int status = 0;
+    std::unique_ptr<char, void (*)(void*)> demangled(abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free);
+    if (status == 0)
+    {
+        return demangled.get();
+    }
+    return name;
+#else
+    // MSVC names are readable already, only the class-key goes
+    std::string readableName = name;
+    for (const std::string prefix : { "struct ", "class " })
+    {
+        if (readableName.starts_with(prefix))
+        {
+            return readableName.substr(prefix.size());
+        }
+    }
+    return readableName;
+#endif
+}
 
 int Entity::GetId() const
 {
     return id;
 }
 
+int Entity::GetGeneration() const
+{
+    return generation;
+}
+
+bool Entity::IsAlive() const
+{
+    return registry->IsAlive(*this);
+}
+
 void Entity::Kill()
 {
     registry->KillEntity(*this);
@@ -19,35 +58,76 @@ void Entity::Tag(const std::string& tag)
     registry->TagEntity(*this, tag);
 }
 
+void Entity::Tag(int tagId)
+{
+    registry->TagEntity(*this, tagId);
+}
+
 bool Entity::HasTag(const std::string& tag) const
 {
     return registry->EntityHasTag(*this, tag);
 }
 
+bool Entity::HasTag(int tagId) const
+{
+    return registry->EntityHasTag(*this, tagId);
+}
+
 void Entity::Group(const std::string& group)
 {
     registry->GroupEntity(*this, group);
 }
 
+void Entity::Group(int groupId)
+{
+    registry->GroupEntity(*this, groupId);
+}
+
 bool Entity::BelongsToGroup(const std::string& group) const
 {
     return registry->EntityBelongsToGroup(*this, group);
 }
 
+bool Entity::BelongsToGroup(int groupId) const
+{
+    return registry->EntityBelongsToGroup(*this, groupId);
+}
+
 void System::AddEntityToSystem(Entity entity)
 {
+    if (entityIndices.Contains(entity.GetId()))
+    {
+        return;
+    }
+
+    entityIndices.Set(entity.GetId(), static_cast<int>(entities.size()));
     entities.push_back(entity);
 }
 
 void System::RemoveEntityFromSystem(Entity entity)
 {
-    entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](Entity other)
+    const int index = entityIndices.Get(entity.GetId());
+    if (index == SparseIndex::INVALID_INDEX)
     {
-        return entity == other;
-    }), entities.end());
+        return;
+    }
+
+    // Move the last member into the hole to keep the vector packed
+    const Entity last = entities.back();
+    entities[index] = last;
+    entityIndices.Set(last.GetId(), index);
+
+    entities.pop_back();
+    entityIndices.Erase(entity.GetId());
+}
+
+void System::RemoveAllEntitiesFromSystem()
+{
+    entities.clear();
+    entityIndices.Clear();
 }
 
-std::vector<Entity> System::GetSystemEntities() const
+std::span<const Entity> System::GetSystemEntities() const
 {
     return entities;
 }
@@ -57,166 +137,1901 @@ const Signature& System::GetComponentSignature() const
     return componentSignature;
 }
 
-Entity Registry::CreateEntity()
+bool System::ConflictsWith(const System& other) const
 {
-    int entityId;
+    // Without declarations we cannot tell what the update touches
+    if (!declaresComponentAccess || !other.declaresComponentAccess)
+    {
+        return true;
+    }
 
-    if (freeIds.empty())
+    return writeSignature.Intersects(other.readSignature)
+        || writeSignature.Intersects(other.writeSignature)
+        || readSignature.Intersects(other.writeSignature);
+}
+
+void SparseIndex::Set(int entityId, int index)
+{
+    const size_t page = entityId / PAGE_SIZE;
+    if (page >= pages.size())
     {
-        // If there are no free ids waiting to be reused
-        entityId = numEntities++;
-        if (entityId >= entityComponentSignatures.size())
+        pages.resize(page + 1);
+    }
+
+    if (!pages[page])
+    {
+        // Allocate the page on first use, with every slot marked as empty
+        pages[page] = std::make_unique<int[]>(PAGE_SIZE);
+        std::fill_n(pages[page].get(), PAGE_SIZE, INVALID_INDEX);
+    }
+
+    pages[page][entityId % PAGE_SIZE] = index;
+}
+
+void SparseIndex::Erase(int entityId)
+{
+    const size_t page = entityId / PAGE_SIZE;
+    if (page < pages.size() && pages[page])
+    {
+        pages[page][entityId % PAGE_SIZE] = INVALID_INDEX;
+    }
+}
+
+void SnapshotWriter::WriteBytes(const void* source, size_t count)
+{
+    const auto* first = static_cast<const std::byte*>(source);
+    bytes.insert(bytes.end(), first, first + count);
+}
+
+void SnapshotWriter::Write(const std::string& value)
+{
+    Write(static_cast<int>(value.size()));
+    WriteBytes(value.data(), value.size());
+}
+
+void SnapshotReader::ReadBytes(void* destination, size_t count)
+{
+    if (hasFailed || count > bytes.size() - offset)
+    {
+        hasFailed = true;
+        std::memset(destination, 0, count);
+        return;
+    }
+
+    std::memcpy(destination, bytes.data() + offset, count);
+    offset += count;
+}
+
+size_t SnapshotWriter::BeginSection()
+{
+    const size_t sectionOffset = bytes.size();
+    Write(0);
+    return sectionOffset;
+}
+
+void SnapshotWriter::EndSection(size_t sectionOffset)
+{
+    const int size = static_cast<int>(bytes.size() - sectionOffset - sizeof(int));
+    std::memcpy(bytes.data() + sectionOffset, &size, sizeof(int));
+}
+
+void SnapshotReader::Skip(size_t count)
+{
+    if (hasFailed || count > bytes.size() - offset)
+    {
+        hasFailed = true;
+        return;
+    }
+
+    offset += count;
+}
+
+// Checks a component section without reading the components: the entity count must fit in the section and the
+// entity ids that follow it must be ids below slotCount that no section listed before. Skips the rest.
+static bool IsComponentSectionValid(SnapshotReader& reader, int slotCount, std::vector<bool>& isEntityListed)
+{
+    const int size = reader.Read<int>();
+    const size_t contentsOffset = reader.GetOffset();
+    const int count = reader.Read<int>();
+    if (reader.HasFailed() || size < static_cast<int>(sizeof(int)) || count < 0 || static_cast<size_t>(count) > (size - sizeof(int)) / sizeof(int))
+    {
+        return false;
+    }
+
+    isEntityListed.resize(slotCount);
+    for (int i = 0; i < count; i++)
+    {
+        const int entityId = reader.Read<int>();
+        if (entityId < 0 || entityId >= slotCount || isEntityListed[entityId])
         {
-            entityComponentSignatures.resize(entityId + 1);
+            return false;
         }
+        isEntityListed[entityId] = true;
     }
-    else
+
+    reader.Skip(size - (reader.GetOffset() - contentsOffset));
+    return !reader.HasFailed();
+}
+
+// Reads a section with readContents(), returns false if that did not read exactly the section
+template<typename TFunc>
+static bool ReadSection(SnapshotReader& reader, TFunc&& readContents)
+{
+    const int size = reader.Read<int>();
+    const size_t contentsOffset = reader.GetOffset();
+    readContents();
+    return !reader.HasFailed() && reader.GetOffset() - contentsOffset == static_cast<size_t>(size);
+}
+
+void SnapshotReader::Read(std::string& value)
+{
+    const int length = Read<int>();
+    if (length < 0 || hasFailed || static_cast<size_t>(length) > bytes.size() - offset)
     {
-        // Reuse an id from the list of previously removed entities
-        entityId = freeIds.front();
-        freeIds.pop_front();
+        hasFailed = true;
+        value.clear();
+        return;
     }
 
-    Entity entity(entityId);
-    entity.registry = this;
-    entitiesToBeAdded.insert(entity);
-    Logger::Log("Entity created with id " + std::to_string(entityId));
+    value.assign(reinterpret_cast<const char*>(bytes.data() + offset), length);
+    offset += length;
+}
 
-    return entity;
+void SparseIndex::Clear()
+{
+    pages.clear();
 }
 
-void Registry::KillEntity(Entity entity)
+size_t SparseIndex::GetAllocatedBytes() const
 {
-    entitiesToBeKilled.insert(entity);
-    Logger::Log("Entity " + std::to_string(entity.GetId()) + " was killed");
+    size_t bytes = pages.capacity() * sizeof(pages[0]);
+    for (const auto& page : pages)
+    {
+        if (page)
+        {
+            bytes += PAGE_SIZE * sizeof(int);
+        }
+    }
+    return bytes;
 }
 
-void Registry::AddEntityToSystems(Entity entity)
+void SparseIndex::ShrinkToFit()
 {
-    const auto entityId = entity.GetId();
+    for (auto& page : pages)
+    {
+        if (page && std::all_of(page.get(), page.get() + PAGE_SIZE, [](int index) { return index == INVALID_INDEX; }))
+        {
+            page.reset();
+        }
+    }
+    while (!pages.empty() && !pages.back())
+    {
+        pages.pop_back();
+    }
+    pages.shrink_to_fit();
+}
 
-    const auto& entityComponentSignature = entityComponentSignatures[entityId];
+size_t MemoryStats::GetTotalBytes() const
+{
+    size_t bytes = entityBytes + tagAndGroupBytes;
+    for (const auto& storage : componentStorages)
+    {
+        bytes += storage.bytes;
+    }
+    return bytes;
+}
 
-    for (auto& system : systems)
+size_t MemoryStats::GetWastedBytes() const
+{
+    size_t bytes = entityWastedBytes;
+    for (const auto& storage : componentStorages)
     {
-        const auto& systemComponentSignature = system.second->GetComponentSignature();
+        bytes += storage.wastedBytes;
+    }
+    return bytes;
+}
+
+Archetype::Chunk::Chunk(size_t bytes) : bytes(bytes)
+{
+    memory = static_cast<std::byte*>(::operator new(bytes, std::align_val_t(64)));
+}
 
-        bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+Archetype::Chunk::~Chunk()
+{
+    ::operator delete(memory, std::align_val_t(64));
+}
+
+Archetype::Archetype(const Signature& signature, const std::vector<ComponentTypeInfo>& typeInfos)
+    : signature(signature),
+      columnPerComponent(MAX_COMPONENTS, -1),
+      addEdges(MAX_COMPONENTS, nullptr),
+      removeEdges(MAX_COMPONENTS, nullptr)
+{
+    // The first column holds the entity ids
+    componentIds.push_back(-1);
+    componentInfos.push_back({ sizeof(int), alignof(int) });
 
-        if (isInterested)
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        if (signature.test(componentId))
         {
-            system.second->AddEntityToSystem(entity);
+            columnPerComponent[componentId] = static_cast<int>(componentIds.size());
+            componentIds.push_back(componentId);
+            componentInfos.push_back(typeInfos[componentId]);
         }
     }
+
+    // Fit as many entities as possible in a chunk, leaving room for the alignment padding of each column
+    size_t bytesPerEntity = 0;
+    size_t alignmentPadding = 0;
+    for (const auto& info : componentInfos)
+    {
+        bytesPerEntity += info.size;
+        alignmentPadding += info.alignment;
+    }
+    chunkCapacity = static_cast<int>(std::max<size_t>(1, (ARCHETYPE_CHUNK_SIZE - alignmentPadding) / bytesPerEntity));
+
+    size_t offset = 0;
+    for (const auto& info : componentInfos)
+    {
+        offset = (offset + info.alignment - 1) / info.alignment * info.alignment;
+        columnOffsets.push_back(offset);
+        offset += info.size * chunkCapacity;
+    }
+    chunkBytes = std::max(offset, ARCHETYPE_CHUNK_SIZE);
 }
 
-void Registry::RemoveEntityFromSystems(Entity entity)
+Archetype::~Archetype()
 {
-    for (auto system : systems)
+    for (int row = 0; row < size; row++)
     {
-        system.second->RemoveEntityFromSystem(entity);
+        for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
+        {
+            componentInfos[column].destroy(GetSlot(column, row));
+        }
     }
 }
 
-void Registry::TagEntity(Entity entity, const std::string& tag)
+int Archetype::Allocate(int entityId)
 {
-    entityPerTag.emplace(tag, entity);
-    tagPerEntity.emplace(entity.GetId(), tag);
+    const int row = size;
+    if (row / chunkCapacity >= static_cast<int>(chunks.size()))
+    {
+        chunks.push_back(std::make_unique<Chunk>(chunkBytes));
+    }
+
+    *static_cast<int*>(GetSlot(0, row)) = entityId;
+    size++;
+    return row;
 }
 
-bool Registry::EntityHasTag(Entity entity, const std::string& tag) const
+void Archetype::MoveRow(int row, Archetype& target, int targetRow)
 {
-    if (tagPerEntity.find(entity.GetId()) == tagPerEntity.end())
+    for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
     {
-        return false;
+        const int componentId = componentIds[column];
+        if (target.HasComponent(componentId))
+        {
+            componentInfos[column].moveConstruct(target.GetComponent(componentId, targetRow), GetSlot(column, row));
+        }
     }
-    return entityPerTag.find(tag)->second == entity;
 }
 
-Entity Registry::GetEntityByTag(const std::string& tag) const
+int Archetype::RemoveRow(int row)
 {
-    return entityPerTag.at(tag);
+    const int lastRow = size - 1;
+    int movedEntityId = -1;
+
+    for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
+    {
+        componentInfos[column].destroy(GetSlot(column, row));
+    }
+
+    if (row != lastRow)
+    {
+        // Move the last row into the hole to keep the archetype packed
+        for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
+        {
+            componentInfos[column].moveConstruct(GetSlot(column, row), GetSlot(column, lastRow));
+            componentInfos[column].destroy(GetSlot(column, lastRow));
+        }
+        movedEntityId = *static_cast<int*>(GetSlot(0, lastRow));
+        *static_cast<int*>(GetSlot(0, row)) = movedEntityId;
+    }
+
+    size--;
+
+    // Release trailing chunks, keeping one spare so entities moving back and forth do not thrash
+    while (static_cast<int>(chunks.size()) > GetChunkCount() + 1)
+    {
+        chunks.pop_back();
+    }
+
+    return movedEntityId;
 }
 
-void Registry::RemoveEntityTag(Entity entity)
+void Archetype::Clear()
 {
-    auto taggedEntity = tagPerEntity.find(entity.GetId());
-    if (taggedEntity != tagPerEntity.end())
+    for (int row = 0; row < size; row++)
+    {
+        for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
+        {
+            componentInfos[column].destroy(GetSlot(column, row));
+        }
+    }
+    size = 0;
+
+    while (chunks.size() > 1)
     {
-        auto tag = taggedEntity->second;
-        entityPerTag.erase(tag);
-        tagPerEntity.erase(taggedEntity);
+        chunks.pop_back();
     }
 }
 
-void Registry::GroupEntity(Entity entity, const std::string& group)
+ComponentStorageStats Archetype::GetMemoryStats() const
 {
-    entitiesPerGroup.emplace(group, std::set<Entity>());
-    entitiesPerGroup[group].emplace(entity);
-    groupPerEntity.emplace(entity.GetId(), group);
+    ComponentStorageStats stats;
+    size_t bytesPerEntity = 0;
+    for (int column = 0; column < static_cast<int>(componentIds.size()); column++)
+    {
+        bytesPerEntity += componentInfos[column].size;
+        if (column > 0)
+        {
+            stats.name += column > 1 ? ", " : "";
+            stats.name += componentInfos[column].name ? componentInfos[column].name : "?";
+        }
+    }
+    if (stats.name.empty())
+    {
+        stats.name = "(no components)";
+    }
+
+    stats.size = size;
+    stats.capacity = static_cast<int>(chunks.size()) * chunkCapacity;
+    stats.bytes = chunks.size() * chunkBytes;
+    stats.wastedBytes = stats.bytes - size * bytesPerEntity;
+    return stats;
 }
 
-bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const
+void Archetype::ShrinkToFit()
 {
-    if (entitiesPerGroup.find(group) == entitiesPerGroup.end())
+    while (static_cast<int>(chunks.size()) > GetChunkCount())
     {
-        return false;
+        chunks.pop_back();
     }
-    auto groupEntities = entitiesPerGroup.at(group);
-    return groupEntities.find(entity.GetId()) != groupEntities.end();
+    chunks.shrink_to_fit();
 }
 
-std::vector<Entity> Registry::GetEntitiesByGroup(const std::string& group) const
+bool Archetype::Serialize(SnapshotWriter& writer) const
+{
+    for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
+    {
+        if (!componentInfos[column].serialize)
+        {
+            return false;
+        }
+    }
+
+    writer.Write(size);
+    for (int chunk = 0; chunk < GetChunkCount(); chunk++)
+    {
+        writer.WriteBytes(GetChunkEntityIds(chunk), GetChunkEntityCount(chunk) * sizeof(int));
+    }
+
+    for (int chunk = 0; chunk < GetChunkCount(); chunk++)
+    {
+        for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
+        {
+            componentInfos[column].serialize(writer, chunks[chunk]->memory + columnOffsets[column], GetChunkEntityCount(chunk));
+        }
+    }
+    return true;
+}
+
+void Archetype::Deserialize(SnapshotReader& reader)
 {
-    auto& setOfEntities = entitiesPerGroup.at(group);
-    return std::vector<Entity>(setOfEntities.begin(), setOfEntities.end());
+    const int count = reader.Read<int>();
+    if (count < 0 || reader.HasFailed())
+    {
+        return;
+    }
+
+    for (int row = 0; row < count; row++)
+    {
+        Allocate(reader.Read<int>());
+    }
+
+    for (int chunk = 0; chunk < GetChunkCount(); chunk++)
+    {
+        for (int column = 1; column < static_cast<int>(componentIds.size()); column++)
+        {
+            componentInfos[column].deserialize(reader, chunks[chunk]->memory + columnOffsets[column], GetChunkEntityCount(chunk));
+        }
+    }
 }
 
-void Registry::RemoveEntityGroup(Entity entity)
+Archetype* ArchetypeStorage::GetOrCreateArchetype(const Signature& signature)
+{
+    auto archetype = archetypes.find(signature);
+    if (archetype != archetypes.end())
+    {
+        return archetype->second.get();
+    }
+
+    auto newArchetype = std::make_unique<Archetype>(signature, componentInfos);
+    Archetype* result = newArchetype.get();
+    archetypes.emplace(signature, std::move(newArchetype));
+    archetypeList.push_back(result);
+    return result;
+}
+
+Archetype* ArchetypeStorage::GetNeighbour(Archetype* archetype, int componentId, bool isAdd)
 {
-    // if in group, remove entity from group management
-    auto groupedEntity = groupPerEntity.find(entity.GetId());
-    if (groupedEntity != groupPerEntity.end())
+    if (!archetype)
+    {
+        Signature signature;
+        signature.set(componentId);
+        return GetOrCreateArchetype(signature);
+    }
+
+    Archetype* neighbour = archetype->GetEdge(componentId, isAdd);
+    if (!neighbour)
     {
-        auto group = entitiesPerGroup.find(groupedEntity->second);
-        if (group != entitiesPerGroup.end())
+        Signature signature = archetype->GetSignature();
+        signature.set(componentId, isAdd);
+        if (signature.none())
         {
-            auto entityInGroup = group->second.find(entity);
-            if (entityInGroup != group->second.end())
-            {
-                group->second.erase(entityInGroup);
-            }
+            return nullptr;
         }
-        groupPerEntity.erase(groupedEntity);
+        neighbour = GetOrCreateArchetype(signature);
+        archetype->SetEdge(componentId, isAdd, neighbour);
     }
+    return neighbour;
 }
 
-void Registry::Update()
+void ArchetypeStorage::MoveEntity(int entityId, Archetype* target, int targetRow)
 {
-    // Processing the entities that are waiting to be created to the active Systems
-    for (auto entity : entitiesToBeAdded)
+    if (locations[entityId].archetype)
     {
-        AddEntityToSystems(entity);
+        locations[entityId].archetype->MoveRow(locations[entityId].row, *target, targetRow);
+        RemoveFromArchetype(entityId);
     }
-    entitiesToBeAdded.clear();
 
-    // Process the entities that are waiting to be killed from the active Systems
-    for (auto entity : entitiesToBeKilled)
+    locations[entityId] = { target, targetRow };
+}
+
+void ArchetypeStorage::AddMemoryStats(MemoryStats& stats) const
+{
+    for (const Archetype* archetype : archetypeList)
     {
-        RemoveEntityFromSystems(entity);
-        entityComponentSignatures[entity.GetId()].reset();
+        stats.componentStorages.push_back(archetype->GetMemoryStats());
+    }
+
+    stats.entityBytes += locations.capacity() * sizeof(EntityLocation);
+    stats.entityWastedBytes += (locations.capacity() - locations.size()) * sizeof(EntityLocation);
+    for (const auto& componentVersions : versions)
+    {
+        stats.entityBytes += componentVersions.capacity() * sizeof(uint32_t);
+        stats.entityWastedBytes += (componentVersions.capacity() - componentVersions.size()) * sizeof(uint32_t);
+    }
+}
+
+void ArchetypeStorage::ShrinkToFit()
+{
+    for (Archetype* archetype : archetypeList)
+    {
+        archetype->ShrinkToFit();
+    }
+    locations.shrink_to_fit();
+    for (auto& componentVersions : versions)
+    {
+        componentVersions.shrink_to_fit();
+    }
+}
+
+bool ArchetypeStorage::Serialize(SnapshotWriter& writer) const
+{
+    int archetypeCount = 0;
+    for (const Archetype* archetype : archetypeList)
+    {
+        archetypeCount += archetype->GetSize() > 0;
+    }
 
-        // Remove entity from component pools
-        for (auto pool : componentPools)
+    writer.Write(archetypeCount);
+    for (const Archetype* archetype : archetypeList)
+    {
+        if (archetype->GetSize() > 0)
         {
-            if (pool)
+            writer.Write(archetype->GetSignature());
+            const size_t sectionOffset = writer.BeginSection();
+            if (!archetype->Serialize(writer))
             {
-                pool->RemoveEntityFromPool(entity.GetId());
+                return false;
             }
+            writer.EndSection(sectionOffset);
+        }
+    }
+    return true;
+}
+
+bool ArchetypeStorage::Deserialize(SnapshotReader& reader)
+{
+    for (Archetype* archetype : archetypeList)
+    {
+        archetype->Clear();
+    }
+    locations.clear();
+
+    const int archetypeCount = reader.Read<int>();
+    for (int i = 0; i < archetypeCount && !reader.HasFailed(); i++)
+    {
+        const Signature signature = reader.Read<Signature>();
+        if (!CanDeserialize(signature))
+        {
+            return false;
         }
 
-        // Make the entity id available to be reused
-        freeIds.push_back(entity.GetId());
+        Archetype* archetype = GetOrCreateArchetype(signature);
+        if (!ReadSection(reader, [&]() { archetype->Deserialize(reader); }))
+        {
+            return false;
+        }
+
+        int row = 0;
+        for (int chunk = 0; chunk < archetype->GetChunkCount(); chunk++)
+        {
+            const int* entityIds = archetype->GetChunkEntityIds(chunk);
+            for (int i = 0; i < archetype->GetChunkEntityCount(chunk); i++, row++)
+            {
+                if (entityIds[i] >= static_cast<int>(locations.size()))
+                {
+                    locations.resize(entityIds[i] + 1);
+                }
+                locations[entityIds[i]] = { archetype, row };
+
+                // Restored components count as written
+                for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+                {
+                    if (signature.test(componentId))
+                    {
+                        StampAddedComponent(componentId, entityIds[i]);
+                    }
+                }
+            }
+        }
+    }
+    return !reader.HasFailed();
+}
+
+bool ArchetypeStorage::CanDeserialize(const Signature& signature) const
+{
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        if (signature.test(componentId) && (componentId >= static_cast<int>(componentInfos.size()) || !componentInfos[componentId].deserialize))
+        {
+            Logger::Err("Snapshot holds component id " + std::to_string(componentId) + " which this registry cannot restore");
+            return false;
+        }
+    }
+    return true;
+}
+
+void ArchetypeStorage::StampAddedComponent(int componentId, int entityId)
+{
+    auto& componentVersions = versions[componentId];
+    if (entityId >= static_cast<int>(componentVersions.size()))
+    {
+        componentVersions.resize(entityId + 1);
+    }
+    componentVersions[entityId] = *changeVersion;
+}
+
+void ArchetypeStorage::RemoveFromArchetype(int entityId)
+{
+    auto& location = locations[entityId];
+    const int movedEntityId = location.archetype->RemoveRow(location.row);
+    if (movedEntityId != -1)
+    {
+        locations[movedEntityId].row = location.row;
+    }
+    location = EntityLocation();
+}
+
+void ArchetypeStorage::RemoveEntity(int entityId)
+{
+    if (entityId < static_cast<int>(locations.size()) && locations[entityId].archetype)
+    {
+        RemoveFromArchetype(entityId);
+    }
+}
+
+Archetype* ArchetypeStorage::AllocateEntities(const Signature& signature, int firstEntityId, int count, int& firstRow)
+{
+    if (firstEntityId + count > static_cast<int>(locations.size()))
+    {
+        locations.resize(firstEntityId + count);
+    }
+
+    Archetype* archetype = GetOrCreateArchetype(signature);
+    firstRow = archetype->GetSize();
+    for (int i = 0; i < count; i++)
+    {
+        locations[firstEntityId + i] = { archetype, archetype->Allocate(firstEntityId + i) };
+    }
+
+    for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+    {
+        if (signature.test(componentId))
+        {
+            for (int entityId = firstEntityId; entityId < firstEntityId + count; entityId++)
+            {
+                StampAddedComponent(componentId, entityId);
+            }
+        }
+    }
+    return archetype;
+}
+
+Entity CommandBuffer::Resolve(Entity entity) const
+{
+    // Placeholders use negative ids: -1 is the first entity created by the buffer, -2 the second...
+    return entity.GetId() < 0 ? createdEntities[-entity.GetId() - 1] : entity;
+}
+
+Entity CommandBuffer::CreateEntity()
+{
+    numEntitiesToCreate++;
+    commands.emplace_back([](Registry& registry, CommandBuffer& buffer)
+    {
+        buffer.createdEntities.push_back(registry.CreateEntity());
+    });
+    return Entity(-numEntitiesToCreate);
+}
+
+Entity CommandBuffer::Instantiate(const Prefab& prefab)
+{
+    return Instantiate(std::make_shared<const Prefab>(prefab));
+}
+
+Entity CommandBuffer::Instantiate(std::shared_ptr<const Prefab> prefab)
+{
+    for (const auto& component : prefab->components)
+    {
+        AddComponentReservation(component.componentId, component.reserveComponents);
+    }
+
+    numEntitiesToCreate++;
+    commands.emplace_back([prefab = std::move(prefab)](Registry& registry, CommandBuffer& buffer)
+    {
+        buffer.createdEntities.push_back(registry.Instantiate(*prefab));
+    });
+    return Entity(-numEntitiesToCreate);
+}
+
+void CommandBuffer::AddComponentReservation(int componentId, void (*reserve)(Registry& registry, int count))
+{
+    if (componentId >= static_cast<int>(componentReservations.size()))
+    {
+        componentReservations.resize(componentId + 1);
+    }
+    componentReservations[componentId].count++;
+    componentReservations[componentId].reserve = reserve;
+}
+
+void CommandBuffer::KillEntity(Entity entity)
+{
+    commands.emplace_back([entity](Registry& registry, CommandBuffer& buffer)
+    {
+        registry.KillEntity(buffer.Resolve(entity));
+    });
+}
+
+void CommandBuffer::TagEntity(Entity entity, const std::string& tag)
+{
+    commands.emplace_back([entity, tag](Registry& registry, CommandBuffer& buffer)
+    {
+        registry.TagEntity(buffer.Resolve(entity), tag);
+    });
+}
+
+void CommandBuffer::GroupEntity(Entity entity, const std::string& group)
+{
+    commands.emplace_back([entity, group](Registry& registry, CommandBuffer& buffer)
+    {
+        registry.GroupEntity(buffer.Resolve(entity), group);
+    });
+}
+
+void CommandBuffer::Apply(Registry& registry)
+{
+    // Grow every storage once from the recorded counts, instead of once per command
+    registry.ReserveEntities(numEntitiesToCreate);
+    for (const auto& reservation : componentReservations)
+    {
+        if (reservation.count > 0)
+        {
+            reservation.reserve(registry, reservation.count);
+        }
+    }
+
+    createdEntities.reserve(numEntitiesToCreate);
+    for (auto& command : commands)
+    {
+        command(registry, *this);
+    }
+
+    Clear();
+}
+
+void CommandBuffer::Clear()
+{
+    commands.clear();
+    componentReservations.clear();
+    createdEntities.clear();
+    numEntitiesToCreate = 0;
+}
+
+void SystemScheduler::RunScheduledSystem(int index)
+{
+    const ScheduledSystem& scheduledSystem = scheduledSystems[index];
+    scheduledSystem.update();
+
+    for (int dependent : scheduledSystem.dependents)
+    {
+        if (--remainingDependencies[dependent] == 0)
+        {
+            threadPool.Submit([this, dependent]() { RunScheduledSystem(dependent); });
+        }
+    }
+
+    // Counted down last, so Run() cannot return while dependents are still being submitted
+    pendingSystems--;
+}
+
+void SystemScheduler::Run()
+{
+    const int count = static_cast<int>(scheduledSystems.size());
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Every update waits for the earlier updates it conflicts with, which keeps the serial order
+    // wherever the order can change the result
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = 0; j < i; j++)
+        {
+            if (scheduledSystems[j].system->ConflictsWith(*scheduledSystems[i].system))
+            {
+                scheduledSystems[j].dependents.push_back(i);
+                scheduledSystems[i].dependencyCount++;
+            }
+        }
+    }
+
+    if (remainingDependenciesCapacity < static_cast<size_t>(count))
+    {
+        remainingDependencies = std::make_unique<std::atomic<int>[]>(count);
+        remainingDependenciesCapacity = count;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        remainingDependencies[i] = scheduledSystems[i].dependencyCount;
+    }
+    pendingSystems = count;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (scheduledSystems[i].dependencyCount == 0)
+        {
+            threadPool.Submit([this, i]() { RunScheduledSystem(i); });
+        }
+    }
+
+    threadPool.Wait(pendingSystems);
+    scheduledSystems.clear();
+}
+
+Entity Registry::CreateEntity()
+{
+    int entityId;
+
+    if (firstFreeId == -1)
+    {
+        // If there are no free ids waiting to be reused
+        entityId = numEntities++;
+        if (entityId >= entityComponentSignatures.size())
+        {
+            entityComponentSignatures.resize(entityId + 1);
+            entityGroupMasks.resize(entityId + 1);
+            tagPerEntity.resize(entityId + 1, -1);
+            entitySlots.resize(entityId + 1);
+        }
+    }
+    else
+    {
+        // Reuse the most recently freed id, its generation was already bumped when it was removed
+        entityId = firstFreeId;
+        firstFreeId = entitySlots[entityId].nextFreeId;
+        entitySlots[entityId].nextFreeId = -1;
+    }
+
+    Entity entity = GetEntityById(entityId);
+    entitiesToBeAdded.push_back(entity);
+    Logger::Log("Entity created with id " + std::to_string(entityId));
+
+    return entity;
+}
+
+Entity Registry::Instantiate(const Prefab& prefab)
+{
+    Entity entity = CreateEntity();
+    InstantiatePrefab(prefab, entity.GetId(), 1);
+    return entity;
+}
+
+std::vector<Entity> Registry::Instantiate(const Prefab& prefab, int count)
+{
+    std::vector<Entity> entities;
+    if (count <= 0)
+    {
+        return entities;
+    }
+
+    // Take a block of new ids instead of the free list, so the storages can be filled as one range
+    const int firstEntityId = numEntities;
+    numEntities += count;
+    if (numEntities > static_cast<int>(entityComponentSignatures.size()))
+    {
+        entityComponentSignatures.resize(numEntities);
+        entityGroupMasks.resize(numEntities);
+        tagPerEntity.resize(numEntities, -1);
+        entitySlots.resize(numEntities);
+    }
+
+    InstantiatePrefab(prefab, firstEntityId, count);
+
+    entities.reserve(count);
+    entitiesToBeAdded.reserve(entitiesToBeAdded.size() + count);
+    for (int entityId = firstEntityId; entityId < numEntities; entityId++)
+    {
+        Entity entity = GetEntityById(entityId);
+        entitiesToBeAdded.push_back(entity);
+        entities.push_back(entity);
+    }
+    Logger::Log("Instantiated " + std::to_string(count) + " entities with ids " + std::to_string(firstEntityId) + " to " + std::to_string(numEntities - 1));
+
+    return entities;
+}
+
+void Registry::InstantiatePrefab(const Prefab& prefab, int firstEntityId, int count)
+{
+    if (!prefab.signature.none())
+    {
+#ifdef ECS_ARCHETYPE_STORAGE
+        for (const auto& component : prefab.components)
+        {
+            component.registerComponent(archetypes);
+        }
+
+        // Every instance has the same signature, so all of them go straight to their final archetype
+        int firstRow;
+        Archetype* archetype = archetypes.AllocateEntities(prefab.signature, firstEntityId, count, firstRow);
+        for (const auto& component : prefab.components)
+        {
+            for (int row = firstRow; row < firstRow + count; row++)
+            {
+                component.copyConstruct(archetype->GetComponent(component.componentId, row), component.value.get());
+            }
+        }
+#else
+        for (const auto& component : prefab.components)
+        {
+            if (component.componentId >= static_cast<int>(componentPools.size()))
+            {
+                componentPools.resize(component.componentId + 1, nullptr);
+            }
+            if (!componentPools[component.componentId])
+            {
+                componentPools[component.componentId] = component.createPool();
+                componentPools[component.componentId]->TrackChanges(&changeVersion);
+            }
+            component.appendCopies(*componentPools[component.componentId], firstEntityId, count, component.value.get());
+        }
+#endif
+    }
+
+    const int groupId = prefab.group.empty() ? -1 : GetGroupId(prefab.group);
+    for (int entityId = firstEntityId; entityId < firstEntityId + count; entityId++)
+    {
+        entityComponentSignatures[entityId] = prefab.signature;
+        if (groupId != -1)
+        {
+            GroupEntity(GetEntityById(entityId), groupId);
+        }
+    }
+
+#ifndef ECS_ARCHETYPE_STORAGE
+    if (groupedComponents.Intersects(prefab.signature))
+    {
+        for (int entityId = firstEntityId; entityId < firstEntityId + count; entityId++)
+        {
+            EnterComponentGroups(entityId, prefab.signature);
+        }
+    }
+#endif
+}
+
+#ifndef ECS_ARCHETYPE_STORAGE
+const Registry::ComponentGroupData* Registry::FindComponentGroup(const Signature& owned, const Signature& observed) const
+{
+    for (const auto& group : componentGroups)
+    {
+        if (group->owned == owned && group->observed == observed)
+        {
+            return group.get();
+        }
+    }
+    return nullptr;
+}
+
+void Registry::DeclareComponentGroup(const Signature& owned, const Signature& observed)
+{
+    if (FindComponentGroup(owned, observed))
+    {
+        return;
+    }
+
+    auto group = std::make_unique<ComponentGroupData>();
+    group->owned = owned;
+    group->observed = observed;
+
+    // A pool can only be sorted for one group, a second owner is kept on record so it is reported once
+    for (const auto& otherGroup : componentGroups)
+    {
+        if (!otherGroup->isRejected && otherGroup->owned.Intersects(owned))
+        {
+            Logger::Err("Component group rejected: one of its owned components is owned by another group, it will be iterated as a view");
+            group->isRejected = true;
+            componentGroups.push_back(std::move(group));
+            return;
+        }
+    }
+
+    owned.ForEachSetBit([&](size_t componentId)
+    {
+        group->ownedComponentIds.push_back(static_cast<int>(componentId));
+        group->required.set(componentId);
+        groupedComponents.set(componentId);
+    });
+    observed.ForEachSetBit([&](size_t componentId)
+    {
+        group->required.set(componentId);
+        groupedComponents.set(componentId);
+    });
+
+    // Pack the entities that already have the components
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        if (entityComponentSignatures[entityId].Contains(group->required))
+        {
+            EnterComponentGroup(*group, entityId);
+        }
+    }
+
+    Logger::Log("Component group declared with " + std::to_string(group->size) + " entities");
+    componentGroups.push_back(std::move(group));
+}
+
+void Registry::EnterComponentGroup(ComponentGroupData& group, int entityId)
+{
+    // The entity joins the packed range by swapping with the first element past it
+    for (int componentId : group.ownedComponentIds)
+    {
+        componentPools[componentId]->SwapToIndex(entityId, group.size);
+    }
+    group.size++;
+}
+
+void Registry::EnterComponentGroups(int entityId, const Signature& addedComponents)
+{
+    const Signature& signature = entityComponentSignatures[entityId];
+    for (auto& group : componentGroups)
+    {
+        // Only the groups the added components complete, the entity is already packed in the others it matches
+        if (!group->isRejected && group->required.Intersects(addedComponents) && signature.Contains(group->required))
+        {
+            EnterComponentGroup(*group, entityId);
+        }
+    }
+}
+
+void Registry::LeaveComponentGroups(int entityId, const Signature& removedComponents)
+{
+    const Signature& signature = entityComponentSignatures[entityId];
+    for (auto& group : componentGroups)
+    {
+        if (!group->isRejected && group->required.Intersects(removedComponents) && signature.Contains(group->required))
+        {
+            // Swap with the last packed element and shrink the range, the pool can then remove it as usual
+            group->size--;
+            for (int componentId : group->ownedComponentIds)
+            {
+                componentPools[componentId]->SwapToIndex(entityId, group->size);
+            }
+        }
+    }
+}
+
+void Registry::RebuildComponentGroups()
+{
+    for (auto& group : componentGroups)
+    {
+        group->size = 0;
+    }
+    if (componentGroups.empty())
+    {
+        return;
+    }
+
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        for (auto& group : componentGroups)
+        {
+            if (!group->isRejected && entityComponentSignatures[entityId].Contains(group->required))
+            {
+                EnterComponentGroup(*group, entityId);
+            }
+        }
+    }
+}
+#endif
+
+void Registry::AddPrefab(const std::string& name, Prefab prefab)
+{
+    prefabs[name] = std::move(prefab);
+}
+
+bool Registry::HasPrefab(const std::string& name) const
+{
+    return prefabs.find(name) != prefabs.end();
+}
+
+const Prefab& Registry::GetPrefab(const std::string& name) const
+{
+    return prefabs.at(name);
+}
+
+void Registry::SubmitCommandBuffer(CommandBuffer& buffer)
+{
+    if (buffer.IsEmpty())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(submittedCommandBuffersMutex);
+    submittedCommandBuffers.push_back(std::move(buffer));
+    buffer.Clear();
+}
+
+// Reserves room for size values, at least doubling the capacity when it grows, so reserving a few more
+// entities every frame does not reallocate every frame
+template<typename T>
+static void ReserveGrowing(std::vector<T>& values, size_t size)
+{
+    if (size > values.capacity())
+    {
+        values.reserve(std::max(size, values.capacity() * 2));
+    }
+}
+
+void Registry::ReserveEntities(int count)
+{
+    const size_t size = numEntities + count;
+    ReserveGrowing(entityComponentSignatures, size);
+    ReserveGrowing(entityGroupMasks, size);
+    ReserveGrowing(tagPerEntity, size);
+    ReserveGrowing(entitySlots, size);
+}
+
+MemoryStats Registry::GetMemoryStats() const
+{
+    MemoryStats stats;
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    archetypes.AddMemoryStats(stats);
+#else
+    for (const auto& pool : componentPools)
+    {
+        if (pool)
+        {
+            stats.componentStorages.push_back(pool->GetMemoryStats());
+        }
+    }
+#endif
+
+    stats.entityIdCount = numEntities;
+    for (int entityId = firstFreeId; entityId != -1; entityId = entitySlots[entityId].nextFreeId)
+    {
+        stats.freeEntityIdCount++;
+    }
+
+    auto addVector = [&](const auto& vector)
+    {
+        using TElement = typename std::decay_t<decltype(vector)>::value_type;
+        stats.entityBytes += vector.capacity() * sizeof(TElement);
+        stats.entityWastedBytes += (vector.capacity() - vector.size()) * sizeof(TElement);
+    };
+    addVector(entityComponentSignatures);
+    addVector(entitySlots);
+    addVector(entityGroupMasks);
+    addVector(tagPerEntity);
+    addVector(entitiesToBeAdded);
+    addVector(entitiesToBeKilled);
+    addVector(signatureChanges);
+#ifndef ECS_ARCHETYPE_STORAGE
+    // Scratch lists are empty between updates, but count like the other vectors
+    for (const auto& entityIds : killedEntityIdsPerPool)
+    {
+        addVector(entityIds);
+    }
+#endif
+
+    // Estimated from the node layout of the usual standard libraries, names past the small string buffer add a block
+    auto getMapBytes = [](const std::unordered_map<std::string, int>& map)
+    {
+        size_t bytes = map.bucket_count() * sizeof(void*);
+        for (const auto& [name, id] : map)
+        {
+            bytes += sizeof(std::pair<const std::string, int>) + 2 * sizeof(void*);
+            bytes += name.capacity() >= sizeof(std::string) ? name.capacity() + 1 : 0;
+        }
+        return bytes;
+    };
+    stats.tagCount = static_cast<int>(tagIds.size());
+    stats.groupCount = static_cast<int>(groupIds.size());
+    stats.tagAndGroupBytes = getMapBytes(tagIds) + getMapBytes(groupIds) + entityPerTag.capacity() * sizeof(Entity);
+
+    return stats;
+}
+
+void Registry::ShrinkToFit()
+{
+#ifdef ECS_ARCHETYPE_STORAGE
+    archetypes.ShrinkToFit();
+#else
+    for (auto& pool : componentPools)
+    {
+        if (pool)
+        {
+            pool->ShrinkToFit();
+        }
+    }
+    for (auto& entityIds : killedEntityIdsPerPool)
+    {
+        entityIds.shrink_to_fit();
+    }
+#endif
+
+    entityComponentSignatures.shrink_to_fit();
+    entitySlots.shrink_to_fit();
+    entityGroupMasks.shrink_to_fit();
+    tagPerEntity.shrink_to_fit();
+    entitiesToBeAdded.shrink_to_fit();
+    entitiesToBeKilled.shrink_to_fit();
+    signatureChanges.shrink_to_fit();
+
+    // Interned tag and group ids may be cached by systems, so the names stay and only the buckets are trimmed
+    tagIds.rehash(0);
+    groupIds.rehash(0);
+    entityPerTag.shrink_to_fit();
+
+    const MemoryStats stats = GetMemoryStats();
+    Logger::Log("Registry shrunk to " + std::to_string(stats.GetTotalBytes()) + " bytes");
+}
+
+// Leading words of every snapshot, so blobs from another build or storage backend are rejected
+static const uint32_t SNAPSHOT_MAGIC = 0x53534345;
+static const uint32_t SNAPSHOT_VERSION = 2;
+#ifdef ECS_ARCHETYPE_STORAGE
+static const uint32_t SNAPSHOT_STORAGE = 1;
+#else
+static const uint32_t SNAPSHOT_STORAGE = 0;
+#endif
+
+// Writes a vector of trivially copyable elements as its size followed by its raw bytes
+template<typename T>
+static void WriteVector(SnapshotWriter& writer, const std::vector<T>& values)
+{
+    writer.Write(static_cast<int>(values.size()));
+    writer.WriteBytes(values.data(), values.size() * sizeof(T));
+}
+
+template<typename T>
+static void ReadVector(SnapshotReader& reader, std::vector<T>& values)
+{
+    const int count = reader.Read<int>();
+    values.resize(reader.HasFailed() || count < 0 ? 0 : count);
+    reader.ReadBytes(values.data(), values.size() * sizeof(T));
+}
+
+// Skips a vector written by WriteVector(), returns its size or -1 if the size is negative
+template<typename T>
+static int SkipVector(SnapshotReader& reader, const std::vector<T>&)
+{
+    const int count = reader.Read<int>();
+    reader.Skip(count < 0 ? SIZE_MAX : count * sizeof(T));
+    return count;
+}
+
+static void WriteEntity(SnapshotWriter& writer, Entity entity)
+{
+    writer.Write(entity.GetId());
+    writer.Write(entity.GetGeneration());
+}
+
+std::vector<std::byte> Registry::Snapshot() const
+{
+    std::vector<std::byte> snapshot;
+    Snapshot(snapshot);
+    return snapshot;
+}
+
+void Registry::Snapshot(std::vector<std::byte>& snapshot) const
+{
+    snapshot.clear();
+    SnapshotWriter writer(snapshot);
+
+    writer.Write(SNAPSHOT_MAGIC);
+    writer.Write(SNAPSHOT_VERSION);
+    writer.Write(SNAPSHOT_STORAGE);
+    writer.Write(MAX_COMPONENTS);
+
+    // Entity ids, generations and per-entity bitsets are plain arrays
+    writer.Write(numEntities);
+    writer.Write(firstFreeId);
+    WriteVector(writer, entitySlots);
+    WriteVector(writer, entityComponentSignatures);
+    WriteVector(writer, entityGroupMasks);
+    WriteVector(writer, tagPerEntity);
+
+    // Tag and group names
+    writer.Write(static_cast<int>(entityPerTag.size()));
+    for (const auto& entity : entityPerTag)
+    {
+        WriteEntity(writer, entity);
+    }
+    writer.Write(static_cast<int>(tagIds.size()));
+    for (const auto& [tag, tagId] : tagIds)
+    {
+        writer.Write(tag);
+        writer.Write(tagId);
+    }
+    writer.Write(static_cast<int>(groupIds.size()));
+    for (const auto& [group, groupId] : groupIds)
+    {
+        writer.Write(group);
+        writer.Write(groupId);
+    }
+
+    // Changes waiting for the next Update()
+    writer.Write(static_cast<int>(entitiesToBeAdded.size()));
+    for (const auto& entity : entitiesToBeAdded)
+    {
+        WriteEntity(writer, entity);
+    }
+    writer.Write(static_cast<int>(entitiesToBeKilled.size()));
+    for (const auto& entity : entitiesToBeKilled)
+    {
+        WriteEntity(writer, entity);
+    }
+    writer.Write(static_cast<int>(signatureChanges.size()));
+    for (const auto& [entity, componentId] : signatureChanges)
+    {
+        WriteEntity(writer, entity);
+        writer.Write(componentId);
+    }
+
+    // Component data
+#ifdef ECS_ARCHETYPE_STORAGE
+    const bool isSerialized = archetypes.Serialize(writer);
+#else
+    bool isSerialized = true;
+    int poolCount = 0;
+    for (const auto& pool : componentPools)
+    {
+        poolCount += pool != nullptr;
+    }
+    writer.Write(poolCount);
+    for (int componentId = 0; componentId < static_cast<int>(componentPools.size()) && isSerialized; componentId++)
+    {
+        if (componentPools[componentId])
+        {
+            writer.Write(componentId);
+            const size_t sectionOffset = writer.BeginSection();
+            isSerialized = componentPools[componentId]->Serialize(writer);
+            writer.EndSection(sectionOffset);
+        }
+    }
+#endif
+
+    if (!isSerialized)
+    {
+        Logger::Err("Snapshot failed: a component type is neither trivially copyable nor has Serialize/Deserialize members");
+        snapshot.clear();
+    }
+}
+
+bool Registry::IsRestorable(SnapshotReader reader) const
+{
+    // Entity ids and per-entity arrays, every array holds a slot for each entity id
+    const int entityCount = reader.Read<int>();
+    const int freeId = reader.Read<int>();
+    const int slotCount = SkipVector(reader, entitySlots);
+    bool isValid = entityCount >= 0 && freeId >= -1 && freeId < entityCount && slotCount >= entityCount;
+    isValid = isValid && SkipVector(reader, entityComponentSignatures) == slotCount;
+    isValid = isValid && SkipVector(reader, entityGroupMasks) == slotCount;
+    isValid = isValid && SkipVector(reader, tagPerEntity) == slotCount;
+
+    auto readEntityId = [&]()
+    {
+        const int entityId = reader.Read<int>();
+        reader.Read<int>();
+        isValid = isValid && entityId >= -1 && entityId < slotCount;
+        return entityId;
+    };
+
+    // Tag and group names
+    const int tagCount = reader.Read<int>();
+    isValid = isValid && tagCount >= 0;
+    for (int i = 0; i < tagCount && isValid && !reader.HasFailed(); i++)
+    {
+        readEntityId();
+    }
+    for (int i = reader.Read<int>(); i > 0 && isValid && !reader.HasFailed(); i--)
+    {
+        std::string tag;
+        reader.Read(tag);
+        const int tagId = reader.Read<int>();
+        isValid = tagId >= 0 && tagId < tagCount;
+    }
+    for (int i = reader.Read<int>(); i > 0 && isValid && !reader.HasFailed(); i--)
+    {
+        std::string group;
+        reader.Read(group);
+        const int groupId = reader.Read<int>();
+        isValid = groupId >= 0 && groupId < static_cast<int>(MAX_GROUPS);
+    }
+
+    // Changes waiting for the next Update() must refer to existing entity ids
+    for (int pendingList = 0; pendingList < 2; pendingList++)
+    {
+        for (int i = reader.Read<int>(); i > 0 && isValid && !reader.HasFailed(); i--)
+        {
+            isValid = readEntityId() >= 0;
+        }
+    }
+    for (int i = reader.Read<int>(); i > 0 && isValid && !reader.HasFailed(); i--)
+    {
+        isValid = readEntityId() >= 0;
+        const int componentId = reader.Read<int>();
+        isValid = isValid && componentId >= 0 && componentId < static_cast<int>(MAX_COMPONENTS);
+    }
+
+    // Component data, every section must be of a component type this registry stores and only list existing entity
+    // ids, each once per pool, or once over all archetypes
+    std::vector<bool> isEntityListed;
+    for (int i = reader.Read<int>(); i > 0 && isValid && !reader.HasFailed(); i--)
+    {
+#ifdef ECS_ARCHETYPE_STORAGE
+        if (!archetypes.CanDeserialize(reader.Read<Signature>()))
+        {
+            return false;
+        }
+#else
+        const int componentId = reader.Read<int>();
+        if (componentId < 0 || componentId >= static_cast<int>(componentPools.size()) || !componentPools[componentId])
+        {
+            Logger::Err("Restore failed: the snapshot holds component id " + std::to_string(componentId) + " which this registry never stored");
+            return false;
+        }
+        isEntityListed.clear();
+#endif
+        isValid = IsComponentSectionValid(reader, slotCount, isEntityListed);
+    }
+
+    if (!isValid || reader.HasFailed() || !reader.IsAtEnd())
+    {
+        Logger::Err("Restore failed: the snapshot is truncated or corrupt");
+        return false;
+    }
+    return true;
+}
+
+bool Registry::Restore(const std::vector<std::byte>& snapshot)
+{
+    SnapshotReader reader(snapshot);
+
+    if (reader.Read<uint32_t>() != SNAPSHOT_MAGIC || reader.Read<uint32_t>() != SNAPSHOT_VERSION ||
+        reader.Read<uint32_t>() != SNAPSHOT_STORAGE || reader.Read<unsigned int>() != MAX_COMPONENTS)
+    {
+        Logger::Err("Restore failed: the snapshot was not written by this build of the registry");
+        return false;
+    }
+
+    // Nothing is overwritten until the whole blob is known to fit this registry
+    if (!IsRestorable(reader))
+    {
+        return false;
+    }
+
+    // Buffers recorded against the world being replaced would apply to unrelated entities
+    {
+        std::lock_guard<std::mutex> lock(submittedCommandBuffersMutex);
+        submittedCommandBuffers.clear();
+    }
+
+    auto readEntity = [&]()
+    {
+        const int entityId = reader.Read<int>();
+        Entity entity(entityId, reader.Read<int>());
+        entity.registry = this;
+        return entity;
+    };
+
+    numEntities = reader.Read<int>();
+    firstFreeId = reader.Read<int>();
+    ReadVector(reader, entitySlots);
+    ReadVector(reader, entityComponentSignatures);
+    ReadVector(reader, entityGroupMasks);
+    ReadVector(reader, tagPerEntity);
+
+    entityPerTag.resize(std::max(reader.Read<int>(), 0), Entity(-1));
+    for (auto& entity : entityPerTag)
+    {
+        entity = readEntity();
+    }
+    tagIds.clear();
+    for (int i = reader.Read<int>(); i > 0 && !reader.HasFailed(); i--)
+    {
+        std::string tag;
+        reader.Read(tag);
+        tagIds[tag] = reader.Read<int>();
+    }
+    groupIds.clear();
+    for (int i = reader.Read<int>(); i > 0 && !reader.HasFailed(); i--)
+    {
+        std::string group;
+        reader.Read(group);
+        groupIds[group] = reader.Read<int>();
+    }
+
+    entitiesToBeAdded.clear();
+    for (int i = reader.Read<int>(); i > 0 && !reader.HasFailed(); i--)
+    {
+        entitiesToBeAdded.push_back(readEntity());
+    }
+    entitiesToBeKilled.clear();
+    for (int i = reader.Read<int>(); i > 0 && !reader.HasFailed(); i--)
+    {
+        entitiesToBeKilled.push_back(readEntity());
+    }
+    signatureChanges.clear();
+    for (int i = reader.Read<int>(); i > 0 && !reader.HasFailed(); i--)
+    {
+        const Entity entity = readEntity();
+        signatureChanges.emplace_back(entity, reader.Read<int>());
+    }
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    bool isRestored = archetypes.Deserialize(reader);
+#else
+    bool isRestored = true;
+    for (auto& pool : componentPools)
+    {
+        if (pool)
+        {
+            pool->Clear();
+        }
+    }
+    for (int i = reader.Read<int>(); i > 0 && isRestored && !reader.HasFailed(); i--)
+    {
+        const int componentId = reader.Read<int>();
+        if (componentId < 0 || componentId >= static_cast<int>(componentPools.size()) || !componentPools[componentId])
+        {
+            Logger::Err("Restore failed: the snapshot holds component id " + std::to_string(componentId) + " which this registry never stored");
+            isRestored = false;
+            break;
+        }
+        isRestored = ReadSection(reader, [&]() { componentPools[componentId]->Deserialize(reader); });
+    }
+
+    // Pools come back in snapshot order, the groups pack them again
+    RebuildComponentGroups();
+#endif
+
+    if (!isRestored || reader.HasFailed())
+    {
+        // Only a component whose Deserialize() reads a different number of bytes than its Serialize() wrote gets here
+        Logger::Err("Restore failed: a component section does not match its type, the world is left inconsistent");
+        return false;
+    }
+
+    // Systems only hold entities that were already admitted by an Update()
+    for (auto& system : systems)
+    {
+        system.second->RemoveAllEntitiesFromSystem();
+    }
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        if (entitySlots[entityId].isInSystems)
+        {
+            AddEntityToSystems(GetEntityById(entityId));
+        }
+    }
+
+    Logger::Log("Registry restored " + std::to_string(numEntities) + " entity ids from a snapshot");
+    return true;
+}
+
+void Registry::KillEntity(Entity entity)
+{
+    if (!IsAlive(entity))
+    {
+        return;
+    }
+
+    {
+        // Killing an entity again before the next Update() changes nothing
+        std::lock_guard<std::mutex> lock(entitiesToBeKilledMutex);
+        auto& slot = entitySlots[entity.GetId()];
+        if (slot.isPendingKill)
+        {
+            return;
+        }
+        slot.isPendingKill = true;
+        entitiesToBeKilled.push_back(entity);
+    }
+    Logger::Log("Entity " + std::to_string(entity.GetId()) + " was killed");
+}
+
+void Registry::SetThreadPool(ThreadPool* threadPool)
+{
+    this->threadPool = threadPool;
+}
+
+ThreadPool* Registry::GetThreadPool() const
+{
+    return threadPool;
+}
+
+void Registry::AddEntityToSystems(Entity entity)
+{
+    const auto entityId = entity.GetId();
+    entitySlots[entityId].isInSystems = true;
+
+    for (auto system : GetSystemsForSignature(entityComponentSignatures[entityId]))
+    {
+        system->AddEntityToSystem(entity);
+    }
+}
+
+void Registry::RemoveEntityFromSystems(Entity entity)
+{
+    // Only the systems interested in the entity's signature can hold it
+    for (auto system : GetSystemsForSignature(entityComponentSignatures[entity.GetId()]))
+    {
+        system->RemoveEntityFromSystem(entity);
+    }
+}
+
+const std::vector<System*>& Registry::GetSystemsForSignature(const Signature& signature)
+{
+    if (systemsForLastSignature && signature == lastSignature)
+    {
+        return *systemsForLastSignature;
+    }
+
+    auto [cached, isNew] = systemsPerSignature.try_emplace(signature);
+    if (isNew)
+    {
+        for (auto& system : systems)
+        {
+            if (signature.Contains(system.second->GetComponentSignature()))
+            {
+                cached->second.push_back(system.second.get());
+            }
+        }
+    }
+
+    // Map nodes do not move, the pointer stays valid until the cache is cleared
+    lastSignature = signature;
+    systemsForLastSignature = &cached->second;
+    return cached->second;
+}
+
+void Registry::UpdateEntitySystems(Entity entity, int componentId)
+{
+    if (componentId >= static_cast<int>(systemsPerComponent.size()))
+    {
+        return;
+    }
+
+    const auto& entityComponentSignature = entityComponentSignatures[entity.GetId()];
+
+    for (auto system : systemsPerComponent[componentId])
+    {
+        const auto& systemComponentSignature = system->GetComponentSignature();
+
+        if (entityComponentSignature.Contains(systemComponentSignature))
+        {
+            system->AddEntityToSystem(entity);
+        }
+        else
+        {
+            system->RemoveEntityFromSystem(entity);
+        }
+    }
+}
+
+void Registry::RebuildSystemsPerComponent()
+{
+    systemsPerComponent.assign(MAX_COMPONENTS, {});
+    systemsPerSignature.clear();
+    systemsForLastSignature = nullptr;
+
+    for (auto& system : systems)
+    {
+        const auto& systemComponentSignature = system.second->GetComponentSignature();
+
+        for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+        {
+            if (systemComponentSignature.test(componentId))
+            {
+                systemsPerComponent[componentId].push_back(system.second.get());
+            }
+        }
+    }
+}
+
+void Registry::OnEntitySignatureChanged(Entity entity, int componentId)
+{
+    // Entities still waiting to be added get matched against every system anyway
+    if (entitySlots[entity.GetId()].isInSystems)
+    {
+        signatureChanges.emplace_back(entity, componentId);
+    }
+}
+
+int Registry::GetTagId(const std::string& tag)
+{
+    auto tagId = tagIds.find(tag);
+    if (tagId != tagIds.end())
+    {
+        return tagId->second;
+    }
+
+    const int newTagId = static_cast<int>(entityPerTag.size());
+    tagIds.emplace(tag, newTagId);
+    entityPerTag.push_back(Entity(-1));
+    return newTagId;
+}
+
+void Registry::TagEntity(Entity entity, const std::string& tag)
+{
+    TagEntity(entity, GetTagId(tag));
+}
+
+void Registry::TagEntity(Entity entity, int tagId)
+{
+    // A tag names a single entity, and an entity has a single tag
+    RemoveEntityTag(entity);
+    if (entityPerTag[tagId].GetId() != -1)
+    {
+        RemoveEntityTag(entityPerTag[tagId]);
+    }
+
+    entityPerTag[tagId] = entity;
+    tagPerEntity[entity.GetId()] = tagId;
+}
+
+int Registry::FindTagId(const std::string& tag) const
+{
+    auto tagId = tagIds.find(tag);
+    return tagId != tagIds.end() ? tagId->second : -1;
+}
+
+bool Registry::EntityHasTag(Entity entity, const std::string& tag) const
+{
+    return EntityHasTag(entity, FindTagId(tag));
+}
+
+Entity Registry::GetEntityByTag(const std::string& tag) const
+{
+    return entityPerTag.at(tagIds.at(tag));
+}
+
+void Registry::RemoveEntityTag(Entity entity)
+{
+    int& tagId = tagPerEntity[entity.GetId()];
+    if (tagId != -1)
+    {
+        entityPerTag[tagId] = Entity(-1);
+        tagId = -1;
+    }
+}
+
+int Registry::GetGroupId(const std::string& group)
+{
+    auto groupId = groupIds.find(group);
+    if (groupId != groupIds.end())
+    {
+        return groupId->second;
+    }
+
+    const int newGroupId = static_cast<int>(groupIds.size());
+    if (newGroupId >= static_cast<int>(MAX_GROUPS))
+    {
+        Logger::Err("Too many entity groups, cannot add group " + group);
+        return -1;
+    }
+    groupIds.emplace(group, newGroupId);
+    return newGroupId;
+}
+
+void Registry::GroupEntity(Entity entity, const std::string& group)
+{
+    GroupEntity(entity, GetGroupId(group));
+}
+
+void Registry::GroupEntity(Entity entity, int groupId)
+{
+    if (groupId >= 0)
+    {
+        entityGroupMasks[entity.GetId()].set(groupId);
+    }
+}
+
+int Registry::FindGroupId(const std::string& group) const
+{
+    auto groupId = groupIds.find(group);
+    return groupId != groupIds.end() ? groupId->second : -1;
+}
+
+bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const
+{
+    return EntityBelongsToGroup(entity, FindGroupId(group));
+}
+
+std::vector<Entity> Registry::GetEntitiesByGroup(const std::string& group) const
+{
+    // Membership is only stored per entity, so listing a group scans every entity id
+    std::vector<Entity> entities;
+    const int groupId = FindGroupId(group);
+    if (groupId == -1)
+    {
+        return entities;
+    }
+
+    for (int entityId = 0; entityId < numEntities; entityId++)
+    {
+        if (entityGroupMasks[entityId].test(groupId))
+        {
+            entities.push_back(GetEntityById(entityId));
+        }
+    }
+    return entities;
+}
+
+void Registry::RemoveEntityGroup(Entity entity)
+{
+    entityGroupMasks[entity.GetId()].reset();
+}
+
+void Registry::Update()
+{
+    // Everything written from here on belongs to the new frame
+    changeVersion++;
+
+    // Apply the structural changes recorded in command buffers, in the order they were submitted
+    std::vector<CommandBuffer> commandBuffers;
+    {
+        std::lock_guard<std::mutex> lock(submittedCommandBuffersMutex);
+        commandBuffers.swap(submittedCommandBuffers);
+    }
+    for (auto& commandBuffer : commandBuffers)
+    {
+        commandBuffer.Apply(*this);
+    }
+
+    // Processing the entities that are waiting to be created to the active Systems. They are flagged from
+    // several threads, so they are taken in id order to keep the system entity lists independent of timing.
+    std::sort(entitiesToBeAdded.begin(), entitiesToBeAdded.end());
+    for (auto entity : entitiesToBeAdded)
+    {
+        AddEntityToSystems(entity);
+    }
+    entitiesToBeAdded.clear();
+
+    // Re-check only the systems affected by components added or removed at runtime
+    for (const auto& [entity, componentId] : signatureChanges)
+    {
+        if (IsAlive(entity))
+        {
+            UpdateEntitySystems(entity, componentId);
+        }
+    }
+    signatureChanges.clear();
+
+    // Process the entities that are waiting to be killed from the active Systems
+    if (!entitiesToBeKilled.empty())
+    {
+        KillPendingEntities();
+    }
+}
+
+void Registry::KillPendingEntities()
+{
+    // Kills arrive from concurrently running systems. Processing them in id order makes the swap-removes,
+    // the dense layouts and the reuse of the freed ids the same as in a serial run.
+    std::sort(entitiesToBeKilled.begin(), entitiesToBeKilled.end());
+
+    for (auto entity : entitiesToBeKilled)
+    {
+        RemoveEntityFromSystems(entity);
+    }
+
+    // Remove the entities from the component storage
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Every entity lives in a single archetype row, which is removed directly
+    for (auto entity : entitiesToBeKilled)
+    {
+        archetypes.RemoveEntity(entity.GetId());
+    }
+#else
+    // Owning groups are unpacked first, while the pools still hold the entities
+    for (auto entity : entitiesToBeKilled)
+    {
+        const Signature& signature = entityComponentSignatures[entity.GetId()];
+        if (groupedComponents.Intersects(signature))
+        {
+            LeaveComponentGroups(entity.GetId(), signature);
+        }
+    }
+
+    // Sort the entities by the pools their signatures say they are in, then empty every pool in one pass
+    killedEntityIdsPerPool.resize(componentPools.size());
+    for (auto entity : entitiesToBeKilled)
+    {
+        entityComponentSignatures[entity.GetId()].ForEachSetBit([&](size_t componentId)
+        {
+            killedEntityIdsPerPool[componentId].push_back(entity.GetId());
+        });
+    }
+    for (size_t componentId = 0; componentId < killedEntityIdsPerPool.size(); componentId++)
+    {
+        auto& entityIds = killedEntityIdsPerPool[componentId];
+        if (!entityIds.empty())
+        {
+            componentPools[componentId]->RemoveEntitiesFromPool(entityIds);
+            entityIds.clear();
+        }
+    }
+#endif
+
+    // The free list is last in, first out, so the ids are pushed from the highest down and reused in id order
+    for (auto it = entitiesToBeKilled.rbegin(); it != entitiesToBeKilled.rend(); ++it)
+    {
+        const Entity entity = *it;
+        entityComponentSignatures[entity.GetId()].reset();
+
+        // Invalidate existing handles and make the entity id available to be reused
+        auto& slot = entitySlots[entity.GetId()];
+        slot.isInSystems = false;
+        slot.isPendingKill = false;
+        slot.generation++;
+        slot.nextFreeId = firstFreeId;
+        firstFreeId = entity.GetId();
 
         // Remove any traces of that entity from the tag/group maps
         RemoveEntityTag(entity);
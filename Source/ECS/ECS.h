@@ -2,31 +2,171 @@
 #define ECS_H
 
 #include "../Logger/Logger.h"
+#include "../ThreadPool/ThreadPool.h"
 #include <vector>
 #include <bitset>
-#include <set>
-#include <deque>
 #include <unordered_map>
 #include <typeindex>
 #include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <concepts>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <functional>
+#include <mutex>
+#include <string>
+
+// Number of component types a signature can hold (CMake option ECS_MAX_COMPONENTS, a multiple of 64)
+#ifndef ECS_MAX_COMPONENTS
+#define ECS_MAX_COMPONENTS 128
+#endif
+
+const unsigned int MAX_COMPONENTS = ECS_MAX_COMPONENTS;
+
+static_assert(MAX_COMPONENTS % 64 == 0, "ECS_MAX_COMPONENTS must be a multiple of 64");
+
+// Component ids below this value are reserved for components that declare a fixed componentId
+const int STATIC_COMPONENT_ID_COUNT = 32;
 
-const unsigned int MAX_COMPONENTS = 32;
+// Components live in one Pool<T> per component type by default. Defining ECS_ARCHETYPE_STORAGE
+// (CMake option of the same name) stores them in archetype chunks instead.
+const size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Signature
 ////////////////////////////////////////////////////////////////////////////////
 // We use a bitset (1s and 0s) to keep track of which components an entity has,
 // and also helps keep track of which entities a system is interested in.
+// The bits are stored in aligned 64-bit words so the subset test used to match
+// entities against systems is a short fixed-length loop the compiler vectorizes.
+// The bit accessors keep the std::bitset names the rest of the code was using.
+////////////////////////////////////////////////////////////////////////////////
+class Signature
+{
+public:
+    static constexpr size_t WORD_BITS = 64;
+    static constexpr size_t WORD_COUNT = MAX_COMPONENTS / WORD_BITS;
+
+    void set(size_t bit, bool value = true)
+    {
+        const uint64_t mask = uint64_t(1) << (bit % WORD_BITS);
+        words[bit / WORD_BITS] = value ? (words[bit / WORD_BITS] | mask) : (words[bit / WORD_BITS] & ~mask);
+    }
+
+    bool test(size_t bit) const
+    {
+        return (words[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+    }
+
+    void reset()
+    {
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            words[i] = 0;
+        }
+    }
+
+    bool none() const
+    {
+        uint64_t any = 0;
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            any |= words[i];
+        }
+        return any == 0;
+    }
+
+    // True if every component set in other is also set in this signature
+    bool Contains(const Signature& other) const
+    {
+        uint64_t missing = 0;
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            missing |= other.words[i] & ~words[i];
+        }
+        return missing == 0;
+    }
+
+    // True if at least one component is set in both signatures
+    bool Intersects(const Signature& other) const
+    {
+        uint64_t common = 0;
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            common |= words[i] & other.words[i];
+        }
+        return common != 0;
+    }
+
+    // Calls func(bit) for every set bit, in increasing order
+    template<typename TFunc>
+    void ForEachSetBit(TFunc&& func) const
+    {
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            for (uint64_t word = words[i]; word != 0; word &= word - 1)
+            {
+                func(i * WORD_BITS + std::countr_zero(word));
+            }
+        }
+    }
+
+    bool operator==(const Signature& other) const = default;
+
+    size_t Hash() const
+    {
+        size_t hash = 0;
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            hash ^= std::hash<uint64_t>()(words[i]) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
+private:
+    alignas(16) uint64_t words[WORD_COUNT] = {};
+};
+
+template<>
+struct std::hash<Signature>
+{
+    size_t operator()(const Signature& signature) const noexcept
+    {
+        return signature.Hash();
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// GroupMask
 ////////////////////////////////////////////////////////////////////////////////
-typedef std::bitset<MAX_COMPONENTS> Signature;
+// Group names are interned to small ids by the registry, and every entity keeps
+// a bitset of the groups it belongs to, so a membership check is one bit test.
+////////////////////////////////////////////////////////////////////////////////
+const unsigned int MAX_GROUPS = 64;
+
+typedef std::bitset<MAX_GROUPS> GroupMask;
 
 struct IComponent
 {
 protected:
     static int nextId;
+
+    // Readable form of a std::type_info name, demangled when the compiler mangles them
+    static std::string DemangleTypeName(const char* name);
 };
 
-// Used to assign a unique id to a component type
+// Used to assign a unique id to a component type.
+// A component can pin its id at compile time with a "static constexpr int componentId = N;"
+// member (N below STATIC_COMPONENT_ID_COUNT), so GetId() folds to a constant. Two types pinning
+// the same N would share one pool, so pinned ids should come from one enum (the game components
+// use Components/ComponentIds.h). Other components get the next free id once, during static
+// initialization.
 template<typename T>
 class Component : public IComponent
 {
@@ -34,9 +174,26 @@ public:
     // Returns the unique id of Component<T>
     static int GetId()
     {
-        static auto id = nextId++;
-        return id;
+        if constexpr (requires { T::componentId; })
+        {
+            static_assert(T::componentId >= 0 && T::componentId < STATIC_COMPONENT_ID_COUNT, "componentId must be below STATIC_COMPONENT_ID_COUNT");
+            return T::componentId;
+        }
+        else
+        {
+            return id;
+        }
+    }
+
+    // Type name of the component, for debug output
+    static const std::string& GetName()
+    {
+        static const std::string name = DemangleTypeName(typeid(T).name());
+        return name;
     }
+
+private:
+    static inline const int id = nextId++;
 };
 
 class Entity
@@ -44,8 +201,11 @@ class Entity
 private:
     int id;
 
+    // Bumped every time the id is recycled, so stale handles can be told apart from the new entity
+    int generation;
+
 public:
-    Entity(int id) : id(id) { };
+    explicit Entity(int id, int generation = 0) : id(id), generation(generation) { };
 
     Entity(const Entity& entity) = default;
 
@@ -53,15 +213,28 @@ public:
 
     int GetId() const;
 
-    // Manage entity tags and groups
+    int GetGeneration() const;
+
+    // Returns false once the entity was killed, even if its id has been reused since
+    bool IsAlive() const;
+
+    // Manage entity tags and groups, by name or by interned id (see Registry::GetTagId/GetGroupId)
     void Tag(const std::string& tag);
 
+    void Tag(int tagId);
+
     bool HasTag(const std::string& tag) const;
 
+    bool HasTag(int tagId) const;
+
     void Group(const std::string& group);
 
+    void Group(int groupId);
+
     bool BelongsToGroup(const std::string& group) const;
 
+    bool BelongsToGroup(int groupId) const;
+
     // Manage entity components
     template<typename TComponent, typename... TArgs>
     void AddComponent(TArgs&&... args);
@@ -72,34 +245,124 @@ public:
     template<typename TComponent>
     bool HasComponent() const;
 
+    // Write access, marks the component as changed (see Registry::ForEachChanged)
     template<typename TComponent>
     TComponent& GetComponent() const;
 
+    // Read access, leaves the change tracking alone
+    template<typename TComponent>
+    const TComponent& ReadComponent() const;
+
     // Operator overloading for entity objects
     Entity& operator =(const Entity& other) = default;
 
     bool operator ==(const Entity& other) const
     {
-        return id == other.id;
+        return id == other.id && generation == other.generation;
     }
 
     bool operator !=(const Entity& other) const
     {
-        return id != other.id;
+        return !(*this == other);
     }
 
     bool operator >(const Entity& other) const
     {
-        return id > other.id;
+        return other < *this;
     }
 
     bool operator <(const Entity& other) const
     {
-        return id < other.id;
+        return id < other.id || (id == other.id && generation < other.generation);
     }
 
     // Hold a pointer to the entity's owner registry
-    class Registry* registry;
+    class Registry* registry = nullptr;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// SparseIndex
+////////////////////////////////////////////////////////////////////////////////
+// Maps entity ids to packed indices using a paged sparse array, so every lookup
+// is plain array indexing. Pages are only allocated for id ranges in use.
+////////////////////////////////////////////////////////////////////////////////
+class SparseIndex
+{
+private:
+    static constexpr int PAGE_SIZE = 4096;
+
+    std::vector<std::unique_ptr<int[]>> pages;
+
+public:
+    static constexpr int INVALID_INDEX = -1;
+
+    // Returns the packed index of the entity, or INVALID_INDEX if it has none
+    int Get(int entityId) const
+    {
+        const size_t page = entityId / PAGE_SIZE;
+        if (page >= pages.size() || !pages[page])
+        {
+            return INVALID_INDEX;
+        }
+        return pages[page][entityId % PAGE_SIZE];
+    }
+
+    bool Contains(int entityId) const
+    {
+        return Get(entityId) != INVALID_INDEX;
+    }
+
+    void Set(int entityId, int index);
+
+    void Erase(int entityId);
+
+    void Clear();
+
+    // Heap memory held by the pages and the page table
+    size_t GetAllocatedBytes() const;
+
+    // Releases the pages that no longer map any entity
+    void ShrinkToFit();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// MemoryStats
+////////////////////////////////////////////////////////////////////////////////
+// Memory held by a registry, as reported by Registry::GetMemoryStats() for the
+// debug panel. Byte counts are the heap blocks reserved by the containers, the
+// wasted part being reserved but unused. Hash maps are estimated.
+////////////////////////////////////////////////////////////////////////////////
+struct ComponentStorageStats
+{
+    // Component type name, or the component names of an archetype
+    std::string name;
+    int size = 0;
+    int capacity = 0;
+    size_t bytes = 0;
+    size_t wastedBytes = 0;
+};
+
+struct MemoryStats
+{
+    // One entry per component pool, or per archetype with ECS_ARCHETYPE_STORAGE
+    std::vector<ComponentStorageStats> componentStorages;
+
+    // Entity ids handed out so far, and how many of them are free to be reused
+    int entityIdCount = 0;
+    int freeEntityIdCount = 0;
+
+    // Per entity bookkeeping: signatures, slots, tags and groups, archetype locations
+    size_t entityBytes = 0;
+    size_t entityWastedBytes = 0;
+
+    // Interned tag and group names, they are kept for the lifetime of the registry
+    int tagCount = 0;
+    int groupCount = 0;
+    size_t tagAndGroupBytes = 0;
+
+    size_t GetTotalBytes() const;
+
+    size_t GetWastedBytes() const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -113,6 +376,14 @@ private:
     Signature componentSignature;
     std::vector<Entity> entities;
 
+    // Components the system update reads and writes, used by the SystemScheduler
+    Signature readSignature;
+    Signature writeSignature;
+    bool declaresComponentAccess = false;
+
+    // Position of every member inside the entities vector, so membership changes are O(1)
+    SparseIndex entityIndices;
+
 public:
     System() = default;
 
@@ -122,13 +393,122 @@ public:
 
     void RemoveEntityFromSystem(Entity entity);
 
-    std::vector<Entity> GetSystemEntities() const;
+    void RemoveAllEntitiesFromSystem();
+
+    // Non-owning view of the entities processed by the system. Membership only changes inside
+    // Registry::Update(), and Kill() merely flags an entity, so the view stays valid for a whole
+    // system update even if entities are created or killed while iterating it.
+    std::span<const Entity> GetSystemEntities() const;
 
     const Signature& GetComponentSignature() const;
 
     // Defines the component type that entities must have to be considered by the system
     template<typename TComponent>
     void RequireComponent();
+
+    // Declare the components the system update reads or writes, so the SystemScheduler can run it
+    // next to systems it does not conflict with. A system that declares nothing always runs alone.
+    template<typename TComponent>
+    void ReadsComponent();
+
+    template<typename TComponent>
+    void WritesComponent();
+
+    // True if the two systems cannot run at the same time
+    bool ConflictsWith(const System& other) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// SnapshotWriter / SnapshotReader
+////////////////////////////////////////////////////////////////////////////////
+// Binary streams used by Registry::Snapshot() and Registry::Restore().
+// Trivially copyable components are written as raw bytes. Any other component
+// needs a pair of member templates, called with one of these streams:
+//     template<typename TWriter> void Serialize(TWriter& writer) const;
+//     template<typename TReader> void Deserialize(TReader& reader);
+// which Write()/Read() the members one by one (std::string is supported).
+////////////////////////////////////////////////////////////////////////////////
+class SnapshotWriter
+{
+private:
+    std::vector<std::byte>& bytes;
+
+public:
+    explicit SnapshotWriter(std::vector<std::byte>& bytes) : bytes(bytes) { };
+
+    void WriteBytes(const void* source, size_t count);
+
+    void Write(const std::string& value);
+
+    template<typename T>
+    void Write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written as raw bytes");
+        WriteBytes(&value, sizeof(T));
+    }
+
+    // A section is prefixed with its size in bytes, so a reader can check or skip it without knowing its contents.
+    // BeginSection() writes a placeholder and returns where it is, EndSection() fills in the size.
+    size_t BeginSection();
+
+    void EndSection(size_t sectionOffset);
+};
+
+class SnapshotReader
+{
+private:
+    const std::vector<std::byte>& bytes;
+    size_t offset = 0;
+    bool hasFailed = false;
+
+public:
+    explicit SnapshotReader(const std::vector<std::byte>& bytes) : bytes(bytes) { };
+
+    // Reading past the end zero-fills the destination and flags the reader as failed
+    void ReadBytes(void* destination, size_t count);
+
+    void Read(std::string& value);
+
+    template<typename T>
+    void Read(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read as raw bytes");
+        ReadBytes(&value, sizeof(T));
+    }
+
+    template<typename T>
+    T Read()
+    {
+        T value;
+        Read(value);
+        return value;
+    }
+
+    // Skipping past the end flags the reader as failed
+    void Skip(size_t count);
+
+    size_t GetOffset() const
+    {
+        return offset;
+    }
+
+    bool IsAtEnd() const
+    {
+        return offset == bytes.size();
+    }
+
+    bool HasFailed() const
+    {
+        return hasFailed;
+    }
+};
+
+// Components that are not trivially copyable provide Serialize()/Deserialize() members
+template<typename T>
+concept SerializableComponent = std::default_initializable<T> && requires(const T& constComponent, T& component, SnapshotWriter& writer, SnapshotReader& reader)
+{
+    constComponent.Serialize(writer);
+    component.Deserialize(reader);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -136,34 +516,100 @@ public:
 ////////////////////////////////////////////////////////////////////////////////
 // A pool is just a vector (contiguous data) of objects of type T
 ////////////////////////////////////////////////////////////////////////////////
+// Change version stamped by storages that no registry tracks
+inline constexpr uint32_t UNTRACKED_CHANGE_VERSION = 0;
+
 class IPool
 {
+protected:
+    // Change version of the owning registry, stamped on every element written through the pool
+    const uint32_t* changeVersion = &UNTRACKED_CHANGE_VERSION;
+
 public:
     virtual ~IPool() = default;
 
-    virtual void RemoveEntityFromPool(int entityId) = 0;
+    void TrackChanges(const uint32_t* changeVersion)
+    {
+        this->changeVersion = changeVersion;
+    }
+
+    // Removes the elements of the entities that are in the pool
+    virtual void RemoveEntitiesFromPool(std::span<const int> entityIds) = 0;
+
+    // Packed index of the entity's element, or SparseIndex::INVALID_INDEX
+    virtual int GetIndex(int entityId) const = 0;
+
+    // Swaps the element of the entity with the element at index, used to keep owning groups packed
+    virtual void SwapToIndex(int entityId, int index) = 0;
+
+    virtual void Clear() = 0;
+
+    virtual ComponentStorageStats GetMemoryStats() const = 0;
+
+    // Gives back the memory reserved beyond the current elements
+    virtual void ShrinkToFit() = 0;
+
+    // Writes the packed elements of the pool, returns false if the component type cannot be serialized
+    virtual bool Serialize(SnapshotWriter& writer) const = 0;
+
+    // Replaces the pool contents with elements written by Serialize()
+    virtual void Deserialize(SnapshotReader& reader) = 0;
 };
 
 template<typename T>
 class Pool : public IPool
 {
 private:
-    // We keep track of the vector of objects and the current number of elements
-    std::vector<T> data;
+    // We keep track of the raw storage of objects, its capacity and the current number of elements.
+    // Only the first size slots hold constructed objects, the rest is reserved memory, so adding a
+    // component constructs it in place and T does not need to be default constructible or copyable.
+    std::allocator<T> allocator;
+    T* data;
+    int capacity;
     int size;
 
-    // Helper maps to keep track of entity ids per index, so the vector is always packed
-    std::unordered_map<int, int> entityIdToIndex;
-    std::unordered_map<int, int> indexToEntityId;
+    // Sparse set bookkeeping, so the vector is always packed:
+    // the dense array holds the entity id of every element, the sparse index points back into it
+    std::vector<int> indexToEntityId;
+    SparseIndex entityIdToIndex;
+
+    // Change version of the last write access to every element, in the same order as the component data
+    std::vector<uint32_t> versions;
+
+    // Moves the elements into newData, a buffer of newCapacity slots, and releases the old buffer
+    void MoveElementsTo(T* newData, int newCapacity)
+    {
+        std::uninitialized_move(data, data + size, newData);
+        std::destroy(data, data + size);
+        if (data)
+        {
+            allocator.deallocate(data, capacity);
+        }
+        data = newData;
+        capacity = newCapacity;
+    }
 
 public:
     Pool(int capacity = 100)
     {
+        this->data = capacity > 0 ? allocator.allocate(capacity) : nullptr;
+        this->capacity = capacity;
         size = 0;
-        data.resize(capacity);
+        indexToEntityId.reserve(capacity);
+        versions.reserve(capacity);
     }
 
-    virtual ~Pool() = default;
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    virtual ~Pool()
+    {
+        Clear();
+        if (data)
+        {
+            allocator.deallocate(data, capacity);
+        }
+    }
 
     bool IsEmpty() const
     {
@@ -175,281 +621,2107 @@ public:
         return size;
     }
 
-    void Clear()
+    bool Has(int entityId) const
     {
-        data.clear();
-        entityIdToIndex.clear();
+        return entityIdToIndex.Contains(entityId);
+    }
+
+    // Grows to at least double the capacity, so reserving a few more elements every frame stays amortized
+    void Reserve(int capacity)
+    {
+        if (capacity > this->capacity)
+        {
+            const int newCapacity = std::max(capacity, this->capacity * 2);
+            MoveElementsTo(allocator.allocate(newCapacity), newCapacity);
+            indexToEntityId.reserve(newCapacity);
+            versions.reserve(newCapacity);
+        }
+    }
+
+    // Entity ids of the packed elements, in the same order as the component data
+    const std::vector<int>& GetEntityIds() const
+    {
+        return indexToEntityId;
+    }
+
+    // Change versions of the packed elements, in the same order as the component data
+    const std::vector<uint32_t>& GetVersions() const
+    {
+        return versions;
+    }
+
+    void Clear() override
+    {
+        std::destroy(data, data + size);
         indexToEntityId.clear();
+        entityIdToIndex.Clear();
+        versions.clear();
         size = 0;
     }
 
-    void Set(int entityId, T object)
+    ComponentStorageStats GetMemoryStats() const override
+    {
+        ComponentStorageStats stats;
+        stats.name = Component<T>::GetName();
+        stats.size = size;
+        stats.capacity = capacity;
+        stats.bytes = capacity * sizeof(T) + indexToEntityId.capacity() * sizeof(int) +
+            versions.capacity() * sizeof(uint32_t) + entityIdToIndex.GetAllocatedBytes();
+        stats.wastedBytes = (capacity - size) * sizeof(T) + (indexToEntityId.capacity() - size) * sizeof(int) +
+            (versions.capacity() - size) * sizeof(uint32_t);
+        return stats;
+    }
+
+    void ShrinkToFit() override
+    {
+        if (capacity > size)
+        {
+            MoveElementsTo(size > 0 ? allocator.allocate(size) : nullptr, size);
+        }
+        indexToEntityId.shrink_to_fit();
+        versions.shrink_to_fit();
+        entityIdToIndex.ShrinkToFit();
+    }
+
+    // Constructs the component of the entity in place from the arguments
+    template<typename... TArgs>
+    T& Emplace(int entityId, TArgs&&... args)
     {
-        if (entityIdToIndex.find(entityId) != entityIdToIndex.end())
+        const int existingIndex = entityIdToIndex.Get(entityId);
+        if (existingIndex != SparseIndex::INVALID_INDEX)
         {
             // If the element already exists, simply replace the component object
-            int index = entityIdToIndex[entityId];
-            data[index] = object;
+            data[existingIndex] = T(std::forward<TArgs>(args)...);
+            versions[existingIndex] = *changeVersion;
+            return data[existingIndex];
         }
-        else
+
+        // When adding a new object, we keep track of the entity ids and their vector index
+        int index = size;
+        if (index >= capacity)
         {
-            // When adding a new object, we keep track of the entity ids and their vector index
-            int index = size;
-            entityIdToIndex.emplace(entityId, index);
-            indexToEntityId.emplace(index, entityId);
-            if (index >= data.capacity())
+            // If necessary, we grow by always doubling the current capacity. The new element is
+            // constructed before the old ones move, in case the arguments refer to one of them.
+            const int newCapacity = capacity > 0 ? capacity * 2 : 1;
+            T* newData = allocator.allocate(newCapacity);
+            bool isConstructed = false;
+            try
+            {
+                std::construct_at(newData + index, std::forward<TArgs>(args)...);
+                isConstructed = true;
+                MoveElementsTo(newData, newCapacity);
+            }
+            catch (...)
             {
-                // If necessary, we resize by always doubling the current capacity
-                data.resize(size * 2);
+                // The pool is left as it was, only the new storage is released
+                if (isConstructed)
+                {
+                    std::destroy_at(newData + index);
+                }
+                allocator.deallocate(newData, newCapacity);
+                throw;
             }
-            data[index] = object;
-            size++;
         }
+        else
+        {
+            std::construct_at(data + index, std::forward<TArgs>(args)...);
+        }
+        entityIdToIndex.Set(entityId, index);
+        indexToEntityId.push_back(entityId);
+        versions.push_back(*changeVersion);
+        size++;
+        return data[index];
+    }
+
+    void Set(int entityId, T object)
+    {
+        Emplace(entityId, std::move(object));
+    }
+
+    // Appends a copy of value for count entities with consecutive ids, none of which may be in the pool yet.
+    // The storage grows at most once for the whole range.
+    void AppendCopies(int firstEntityId, int count, const T& value)
+    {
+        Reserve(size + count);
+
+        std::uninitialized_fill_n(data + size, count, value);
+        for (int i = 0; i < count; i++)
+        {
+            entityIdToIndex.Set(firstEntityId + i, size + i);
+            indexToEntityId.push_back(firstEntityId + i);
+        }
+        versions.insert(versions.end(), count, *changeVersion);
+        size += count;
     }
 
     void Remove(int entityId)
     {
-        // Copy the last element to the deleted position to keep the array packed
-        int indexOfRemoved = entityIdToIndex[entityId];
+        // Move the last element to the deleted position to keep the array packed
+        int indexOfRemoved = entityIdToIndex.Get(entityId);
         int indexOfLast = size - 1;
-        data[indexOfRemoved] = data[indexOfLast];
+        if (indexOfRemoved != indexOfLast)
+        {
+            data[indexOfRemoved] = std::move(data[indexOfLast]);
+        }
+        std::destroy_at(data + indexOfLast);
 
-        // Update the index-entity maps to point to the correct elements
+        // Point the sparse index of the moved element to its new position
         int entityIdOfLastElement = indexToEntityId[indexOfLast];
-        entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;
+        entityIdToIndex.Set(entityIdOfLastElement, indexOfRemoved);
         indexToEntityId[indexOfRemoved] = entityIdOfLastElement;
+        versions[indexOfRemoved] = versions[indexOfLast];
 
-        entityIdToIndex.erase(entityId);
-        indexToEntityId.erase(indexOfLast);
+        entityIdToIndex.Erase(entityId);
+        indexToEntityId.pop_back();
+        versions.pop_back();
 
         size--;
     }
 
-    void RemoveEntityFromPool(int entityId) override
+    bool Serialize(SnapshotWriter& writer) const override
     {
-        if (entityIdToIndex.find(entityId) != entityIdToIndex.end())
+        if constexpr (!std::is_trivially_copyable_v<T> && !SerializableComponent<T>)
         {
-            Remove(entityId);
+            // Empty pools cost nothing to skip, the others would leave entities without their component
+            if (size > 0)
+            {
+                return false;
+            }
         }
-    }
 
-    T& Get(int entityId)
-    {
-        int index = entityIdToIndex[entityId];
-        return static_cast<T &>(data[index]);
+        writer.Write(size);
+        writer.WriteBytes(indexToEntityId.data(), size * sizeof(int));
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+            writer.WriteBytes(data, size * sizeof(T));
+        }
+        else if constexpr (SerializableComponent<T>)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                data[i].Serialize(writer);
+            }
+        }
+        return true;
     }
 
-    T& operator [](unsigned int index)
+    void Deserialize(SnapshotReader& reader) override
     {
-        return data[index];
-    }
-};
+        Clear();
 
-////////////////////////////////////////////////////////////////////////////////
-// Registry
-////////////////////////////////////////////////////////////////////////////////
-// The registry manages the creation and destruction of entities, add systems,
-// and components.
-////////////////////////////////////////////////////////////////////////////////
-class Registry
+        const int count = reader.Read<int>();
+        if (count < 0 || reader.HasFailed())
+        {
+            return;
+        }
+        Reserve(count);
+        indexToEntityId.resize(count);
+        reader.ReadBytes(indexToEntityId.data(), count * sizeof(int));
+
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+            // Trivially copyable objects can be brought back with a plain copy of their bytes
+            reader.ReadBytes(data, count * sizeof(T));
+        }
+        else if constexpr (SerializableComponent<T>)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                std::construct_at(data + i);
+                data[i].Deserialize(reader);
+            }
+        }
+        size = count;
+
+        // Restored elements count as written
+        versions.assign(count, *changeVersion);
+        for (int i = 0; i < count; i++)
+        {
+            entityIdToIndex.Set(indexToEntityId[i], i);
+        }
+    }
+
+    void RemoveEntitiesFromPool(std::span<const int> entityIds) override
+    {
+        for (int entityId : entityIds)
+        {
+            if (entityIdToIndex.Contains(entityId))
+            {
+                Remove(entityId);
+            }
+        }
+    }
+
+    int GetIndex(int entityId) const override
+    {
+        return entityIdToIndex.Get(entityId);
+    }
+
+    void SwapToIndex(int entityId, int index) override
+    {
+        const int currentIndex = entityIdToIndex.Get(entityId);
+        if (currentIndex == index)
+        {
+            return;
+        }
+
+        const int otherEntityId = indexToEntityId[index];
+        std::swap(data[currentIndex], data[index]);
+        std::swap(versions[currentIndex], versions[index]);
+        indexToEntityId[currentIndex] = otherEntityId;
+        indexToEntityId[index] = entityId;
+        entityIdToIndex.Set(otherEntityId, currentIndex);
+        entityIdToIndex.Set(entityId, index);
+    }
+
+    // Write access, stamps the element with the current change version
+    T& Get(int entityId)
+    {
+        int index = entityIdToIndex.Get(entityId);
+        versions[index] = *changeVersion;
+        return data[index];
+    }
+
+    // Read access, leaves the change version alone
+    const T& Read(int entityId) const
+    {
+        return data[entityIdToIndex.Get(entityId)];
+    }
+
+    uint32_t GetVersion(int entityId) const
+    {
+        return versions[entityIdToIndex.Get(entityId)];
+    }
+
+    T& operator [](unsigned int index)
+    {
+        versions[index] = *changeVersion;
+        return data[index];
+    }
+
+    // Read access by packed index
+    const T& ReadAt(int index) const
+    {
+        return data[index];
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Archetype
+////////////////////////////////////////////////////////////////////////////////
+// An archetype stores all entities that have exactly the same signature.
+// Entities are packed into fixed-size chunks, and every chunk keeps one column
+// (SoA) per component, so iterating several components streams over
+// contiguous memory. Only used when ECS_ARCHETYPE_STORAGE is defined.
+////////////////////////////////////////////////////////////////////////////////
+struct ComponentTypeInfo
+{
+    size_t size = 0;
+    size_t alignment = 0;
+    const char* name = nullptr;
+    void (*moveConstruct)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* object) = nullptr;
+
+    // Write or read count adjacent objects for snapshots, deserialize constructs them in place.
+    // Null when the component type cannot be serialized.
+    void (*serialize)(SnapshotWriter& writer, const void* objects, int count) = nullptr;
+    void (*deserialize)(SnapshotReader& reader, void* objects, int count) = nullptr;
+};
+
+class Archetype
 {
 private:
-    int numEntities = 0;
+    struct Chunk
+    {
+        std::byte* memory;
+        size_t bytes;
+
+        Chunk(size_t bytes);
+        ~Chunk();
+    };
+
+    Signature signature;
+
+    // Component ids of the columns, and their type information
+    std::vector<int> componentIds;
+    std::vector<ComponentTypeInfo> componentInfos;
+
+    // Byte offset of every column inside a chunk, the entity id column always comes first
+    std::vector<size_t> columnOffsets;
+
+    // [Vector index = component type id] [Value = column index, or -1]
+    std::vector<int> columnPerComponent;
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    int chunkCapacity;
+    size_t chunkBytes;
+    int size = 0;
+
+    // Archetypes reached by adding or removing one component, resolved on first use
+    std::vector<Archetype*> addEdges;
+    std::vector<Archetype*> removeEdges;
+
+    void* GetSlot(int column, int row) const
+    {
+        const auto& chunk = chunks[row / chunkCapacity];
+        return chunk->memory + columnOffsets[column] + (row % chunkCapacity) * componentInfos[column].size;
+    }
+
+public:
+    Archetype(const Signature& signature, const std::vector<ComponentTypeInfo>& typeInfos);
+
+    ~Archetype();
+
+    Archetype(const Archetype&) = delete;
+
+    Archetype& operator =(const Archetype&) = delete;
+
+    const Signature& GetSignature() const
+    {
+        return signature;
+    }
+
+    int GetSize() const
+    {
+        return size;
+    }
+
+    bool HasComponent(int componentId) const
+    {
+        return columnPerComponent[componentId] != -1;
+    }
+
+    void* GetComponent(int componentId, int row) const
+    {
+        return GetSlot(columnPerComponent[componentId], row);
+    }
+
+    // Chunk level access used by views to stream over the columns
+    int GetChunkCount() const
+    {
+        return (size + chunkCapacity - 1) / chunkCapacity;
+    }
+
+    int GetChunkEntityCount(int chunk) const
+    {
+        return std::min(chunkCapacity, size - chunk * chunkCapacity);
+    }
+
+    const int* GetChunkEntityIds(int chunk) const
+    {
+        return reinterpret_cast<const int*>(chunks[chunk]->memory);
+    }
+
+    template<typename TComponent>
+    TComponent* GetChunkColumn(int chunk) const;
+
+    Archetype* GetEdge(int componentId, bool isAdd) const
+    {
+        return isAdd ? addEdges[componentId] : removeEdges[componentId];
+    }
+
+    void SetEdge(int componentId, bool isAdd, Archetype* archetype)
+    {
+        (isAdd ? addEdges : removeEdges)[componentId] = archetype;
+    }
+
+    // Reserves a row at the end of the archetype, component slots are left unconstructed
+    int Allocate(int entityId);
+
+    // Move-constructs the components shared with the target archetype into one of its rows
+    void MoveRow(int row, Archetype& target, int targetRow);
+
+    // Destroys the components of a row and moves the last row into the hole.
+    // Returns the id of the entity that was moved, or -1 if no entity moved.
+    int RemoveRow(int row);
+
+    // Destroys every row
+    void Clear();
+
+    ComponentStorageStats GetMemoryStats() const;
+
+    // Releases the chunks past the last row, including the spare one kept by RemoveRow()
+    void ShrinkToFit();
+
+    // Writes the entity ids and then the columns chunk by chunk, returns false if a component type cannot be serialized
+    bool Serialize(SnapshotWriter& writer) const;
+
+    // Appends the rows written by Serialize() to an empty archetype
+    void Deserialize(SnapshotReader& reader);
+};
+
+class ArchetypeStorage
+{
+private:
+    struct EntityLocation
+    {
+        Archetype* archetype = nullptr;
+        int row = -1;
+    };
 
-    // Vector of component pools, each pool contains all the data for a certain compoenent type
     // [Vector index = component type id]
-    // [Pool index = entity id]
-    std::vector<std::shared_ptr<IPool>> componentPools;
+    std::vector<ComponentTypeInfo> componentInfos;
+
+    // [Map key = signature]
+    std::unordered_map<Signature, std::unique_ptr<Archetype>> archetypes;
+    std::vector<Archetype*> archetypeList;
 
-    // Vector of component signatures per entity, saying which component is turned "on" for a given entity
     // [Vector index = entity id]
-    std::vector<Signature> entityComponentSignatures;
+    std::vector<EntityLocation> locations;
 
-    // Map of active systems
-    // [Map key = system type id]
-    std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
+    // Change version of the last write access to every component of every entity. Sized when components
+    // are added, so concurrent writers of different entities only ever store into existing slots.
+    // [Vector index = component type id] [Vector index = entity id]
+    std::vector<std::vector<uint32_t>> versions;
+    const uint32_t* changeVersion = &UNTRACKED_CHANGE_VERSION;
 
-    // Set of entities that are flagged to be added or removed in the next registry Update()
-    std::set<Entity> entitiesToBeAdded;
-    std::set<Entity> entitiesToBeKilled;
+    Archetype* GetOrCreateArchetype(const Signature& signature);
 
-    // Entity tags (one tag name per entity)
-    std::unordered_map<std::string, Entity> entityPerTag;
-    std::unordered_map<int, std::string> tagPerEntity;
+    // Stamps the component of an entity that was just added or restored
+    void StampAddedComponent(int componentId, int entityId);
 
-    // Entity groups (a set of entities per group name)
-    std::unordered_map<std::string, std::set<Entity>> entitiesPerGroup;
-    std::unordered_map<int, std::string> groupPerEntity;
+    Archetype* GetNeighbour(Archetype* archetype, int componentId, bool isAdd);
 
-    // List of free entity ids that were previously removed
-    std::deque<int> freeIds;
+    // Moves the components of an entity into a row already allocated in the target archetype
+    void MoveEntity(int entityId, Archetype* target, int targetRow);
+
+    void RemoveFromArchetype(int entityId);
 
 public:
-    Registry()
+    ArchetypeStorage() = default;
+
+    ArchetypeStorage(const ArchetypeStorage&) = delete;
+
+    ArchetypeStorage& operator =(const ArchetypeStorage&) = delete;
+
+    template<typename TComponent>
+    void RegisterComponent();
+
+    template<typename TComponent, typename... TArgs>
+    void Emplace(int entityId, TArgs&&... args);
+
+    template<typename TComponent>
+    void Remove(int entityId);
+
+    // Write access, stamps the component with the current change version
+    template<typename TComponent>
+    TComponent& Get(int entityId);
+
+    // Read access, leaves the change version alone
+    template<typename TComponent>
+    const TComponent& Read(int entityId) const;
+
+    void TrackChanges(const uint32_t* changeVersion)
+    {
+        this->changeVersion = changeVersion;
+    }
+
+    uint32_t GetVersion(int componentId, int entityId) const
+    {
+        return versions[componentId][entityId];
+    }
+
+    // Stamps a component written in place, e.g. through a view
+    void MarkChanged(int componentId, int entityId)
+    {
+        versions[componentId][entityId] = *changeVersion;
+    }
+
+    void RemoveEntity(int entityId);
+
+    // Allocates rows for count entities with consecutive ids, none of which may have components yet, in the
+    // archetype of the signature. Component slots are left unconstructed. Returns the archetype and its first row.
+    Archetype* AllocateEntities(const Signature& signature, int firstEntityId, int count, int& firstRow);
+
+    // Appends the stats of every archetype, and adds the entity locations and change versions to the entity bookkeeping
+    void AddMemoryStats(MemoryStats& stats) const;
+
+    void ShrinkToFit();
+
+    // Writes every non-empty archetype, returns false if a component type cannot be serialized
+    bool Serialize(SnapshotWriter& writer) const;
+
+    // Replaces all entities with the ones written by Serialize(). Fails if the snapshot holds a component
+    // type this storage has never stored.
+    bool Deserialize(SnapshotReader& reader);
+
+    // True if every component of the signature was stored before, so an archetype of it can be deserialized
+    bool CanDeserialize(const Signature& signature) const;
+
+    // Calls func(archetype) for every non-empty archetype containing all the components of the signature
+    template<typename TFunc>
+    void ForEachArchetype(const Signature& signature, TFunc&& func) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// ComponentView
+////////////////////////////////////////////////////////////////////////////////
+// A view iterates all entities that have every one of the given components.
+// It walks the packed entity ids of the smallest pool (or the chunks of every
+// matching archetype) and hands the components straight to a callback, without
+// going through Entity::GetComponent(). Components viewed as const types
+// (View<TransformComponent, const SpriteComponent>) are only read, the others
+// count as written for change tracking.
+////////////////////////////////////////////////////////////////////////////////
+template<typename... TComponents>
+class ComponentView
+{
+private:
+    class Registry* registry;
+#ifdef ECS_ARCHETYPE_STORAGE
+    ArchetypeStorage* storage;
+#else
+    std::tuple<Pool<std::remove_const_t<TComponents>>*...> pools;
+#endif
+
+public:
+#ifdef ECS_ARCHETYPE_STORAGE
+    ComponentView(class Registry* registry, ArchetypeStorage* storage) : registry(registry), storage(storage) { };
+#else
+    ComponentView(class Registry* registry, Pool<std::remove_const_t<TComponents>>*... pools) : registry(registry), pools(pools...) { };
+#endif
+
+    // Calls func(entity, components&...) or func(components&...) for every matching entity.
+    // Kill() and CreateEntity() are deferred and safe to call, but adding or removing
+    // components of the viewed types while iterating is not.
+    template<typename TFunc>
+    void Each(TFunc&& func) const;
+
+    // Same as Each(), but splits the entities into chunks of about chunkSize and runs them on the
+    // registry thread pool (serially if it has none). The callback runs on several threads at once:
+    // it may write the viewed components of its own entity and call Kill(), and should gather any
+    // other output in ThreadLocalBuffers.
+    template<typename TFunc>
+    void ParallelForEach(int chunkSize, TFunc&& func) const;
+
+private:
+    // Calls func for the entity, whose components are known to be in the view
+#ifdef ECS_ARCHETYPE_STORAGE
+    template<typename TFunc>
+    void Invoke(TFunc& func, int entityId, TComponents*... components) const;
+
+    // Stamps the component of the entity, unless it is viewed as const
+    template<typename TComponent>
+    void MarkWritten(int entityId) const;
+
+    // Calls func(archetype, chunk) for every chunk of every matching archetype
+    template<typename TFunc>
+    void ForEachChunk(TFunc&& func) const;
+#else
+    template<typename TFunc>
+    void Invoke(TFunc& func, int entityId) const;
+
+    template<typename TComponent>
+    Pool<std::remove_const_t<TComponent>>* GetPool() const
+    {
+        return std::get<Pool<std::remove_const_t<TComponent>>*>(pools);
+    }
+
+    // Write access to the component, or read access if it is viewed as const
+    template<typename TComponent>
+    TComponent& Fetch(int entityId) const;
+
+    // Packed entity ids of the smallest viewed pool, or nullptr if some viewed pool does not exist
+    const std::vector<int>* GetSmallestEntityIds() const;
+#endif
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// ComponentGroup
+////////////////////////////////////////////////////////////////////////////////
+// An owning group keeps the entities that have all of its components packed at
+// the front of the pools it owns, in the same order in every one of them, so
+// iterating it walks plain arrays side by side. A component type is owned by
+// one group at most. A group can also observe other component types, which its
+// entities must have but which are looked up through their pool as in a view.
+// Groups are declared once by Registry::DeclareGroup(), kept packed as
+// components are added and removed, and iterated through Registry::Group().
+// Archetype chunks already store the components of an entity side by side, so
+// with archetype storage a group is simply a view.
+////////////////////////////////////////////////////////////////////////////////
+template<typename... TComponents>
+struct Observed { };
+
+template<typename TObserved, typename... TOwned>
+class ComponentGroup;
+
+template<typename... TObserved, typename... TOwned>
+class ComponentGroup<Observed<TObserved...>, TOwned...>
+{
+private:
+    static_assert(sizeof...(TOwned) > 0, "A group must own at least one component type");
+
+    class Registry* registry;
+    ComponentView<TOwned..., TObserved...> view;
+#ifndef ECS_ARCHETYPE_STORAGE
+    std::tuple<Pool<std::remove_const_t<TOwned>>*...> ownedPools;
+    std::tuple<Pool<std::remove_const_t<TObserved>>*...> observedPools;
+
+    // Number of packed entities, kept by the registry. Null if the group was rejected or not declared,
+    // it then iterates as a view.
+    const int* size;
+#endif
+
+public:
+#ifdef ECS_ARCHETYPE_STORAGE
+    ComponentGroup(class Registry* registry, ArchetypeStorage* storage) : registry(registry), view(registry, storage) { };
+#else
+    ComponentGroup(class Registry* registry, Pool<std::remove_const_t<TOwned>>*... ownedPools, Pool<std::remove_const_t<TObserved>>*... observedPools, const int* size)
+        : registry(registry), view(registry, ownedPools..., observedPools...), ownedPools(ownedPools...), observedPools(observedPools...), size(size) { };
+#endif
+
+    // Calls func(entity, owned&..., observed&...) or func(owned&..., observed&...) for every entity of the group.
+    // Same rules as ComponentView::Each(), and const component types are only read.
+    template<typename TFunc>
+    void Each(TFunc&& func) const;
+
+    // Same as ComponentView::ParallelForEach(), over the entities of the group
+    template<typename TFunc>
+    void ParallelForEach(int chunkSize, TFunc&& func) const;
+
+#ifndef ECS_ARCHETYPE_STORAGE
+private:
+    // Calls func for the entity packed at index
+    template<typename TFunc>
+    void Invoke(TFunc& func, int index, int entityId) const;
+
+    // Write access to an owned component, or read access if it is const
+    template<typename TComponent>
+    TComponent& FetchOwned(int index) const;
+
+    template<typename TComponent>
+    TComponent& FetchObserved(int entityId) const;
+#endif
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Prefab
+////////////////////////////////////////////////////////////////////////////////
+// A prefab is an entity template: a set of components with default values and
+// an optional group, built once and instantiated many times. Instantiating a
+// batch grows every component storage once and fills it in one go, instead of
+// adding the components entity by entity.
+////////////////////////////////////////////////////////////////////////////////
+class Prefab
+{
+private:
+    struct ComponentDefault
+    {
+        int componentId;
+
+        // Default values are never modified once added, so copies of a prefab can share them
+        std::shared_ptr<const void> value;
+
+        // Registry::ReserveComponents() of the type, for command buffers reserving ahead of instances
+        void (*reserveComponents)(class Registry& registry, int count);
+
+#ifdef ECS_ARCHETYPE_STORAGE
+        void (*registerComponent)(ArchetypeStorage& storage);
+        void (*copyConstruct)(void* destination, const void* value);
+#else
+        std::shared_ptr<IPool> (*createPool)();
+        void (*appendCopies)(IPool& pool, int firstEntityId, int count, const void* value);
+#endif
+    };
+
+    // Sorted by component id
+    std::vector<ComponentDefault> components;
+    Signature signature;
+    std::string group;
+
+    friend class Registry;
+    friend class CommandBuffer;
+
+public:
+    Prefab() = default;
+
+    // Adds a component built from the arguments, or replaces its default value if the prefab already has it
+    template<typename TComponent, typename... TArgs>
+    Prefab& AddComponent(TArgs&&... args);
+
+    template<typename TComponent>
+    bool HasComponent() const
+    {
+        return signature.test(Component<TComponent>::GetId());
+    }
+
+    // Every instance joins this group, an empty name means no group
+    Prefab& Group(const std::string& group)
+    {
+        this->group = group;
+        return *this;
+    }
+
+    const Signature& GetSignature() const
+    {
+        return signature;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// CommandBuffer
+////////////////////////////////////////////////////////////////////////////////
+// A command buffer records structural changes (create, kill, add and remove
+// components, tags and groups) so the registry can apply them in bulk inside
+// Registry::Update(). Recording never touches the registry, so every thread can
+// safely fill its own buffer and submit it.
+////////////////////////////////////////////////////////////////////////////////
+class CommandBuffer
+{
+private:
+    using Command = std::function<void(class Registry& registry, CommandBuffer& buffer)>;
+
+    struct ComponentReservation
+    {
+        int count = 0;
+        void (*reserve)(class Registry& registry, int count) = nullptr;
+    };
+
+    std::vector<Command> commands;
+
+    // Recorded counts, used to reserve storage up front when the buffer is applied
+    // [Vector index = component type id]
+    std::vector<ComponentReservation> componentReservations;
+    int numEntitiesToCreate = 0;
+
+    // Entities created while applying the buffer [Vector index = placeholder index]
+    std::vector<Entity> createdEntities;
+
+    // Maps placeholder handles returned by CreateEntity() to the entities actually created
+    Entity Resolve(Entity entity) const;
+
+    // Counts one more component of the type to reserve when the buffer is applied
+    void AddComponentReservation(int componentId, void (*reserve)(class Registry& registry, int count));
+
+public:
+    CommandBuffer() = default;
+
+    bool IsEmpty() const
+    {
+        return commands.empty();
+    }
+
+    // Returns a placeholder handle that is only valid for commands recorded in this buffer
+    Entity CreateEntity();
+
+    // Same as CreateEntity(), the entity gets the components and group of the prefab as it is now.
+    // The prefab is copied, the shared_ptr overload avoids the copy for prefabs instantiated often.
+    Entity Instantiate(const Prefab& prefab);
+
+    Entity Instantiate(std::shared_ptr<const Prefab> prefab);
+
+    void KillEntity(Entity entity);
+
+    void TagEntity(Entity entity, const std::string& tag);
+
+    void GroupEntity(Entity entity, const std::string& group);
+
+    template<typename TComponent, typename... TArgs>
+    void AddComponent(Entity entity, TArgs&&... args);
+
+    template<typename TComponent>
+    void RemoveComponent(Entity entity);
+
+    // Applies every recorded command in order, and leaves the buffer empty
+    void Apply(class Registry& registry);
+
+    void Clear();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// SystemScheduler
+////////////////////////////////////////////////////////////////////////////////
+// Runs the system updates of a frame on a thread pool. Updates are scheduled in
+// the order a serial frame would run them. Run() makes every update wait for
+// the earlier ones it conflicts with (see System::ConflictsWith) and lets the
+// others run at the same time, so the frame gives the same result as running
+// the updates one after another.
+////////////////////////////////////////////////////////////////////////////////
+class SystemScheduler
+{
+private:
+    struct ScheduledSystem
+    {
+        const System* system;
+        std::function<void()> update;
+
+        // Later updates that have to wait for this one
+        std::vector<int> dependents;
+        int dependencyCount = 0;
+    };
+
+    ThreadPool& threadPool;
+    std::vector<ScheduledSystem> scheduledSystems;
+
+    // Reused every frame: number of unfinished dependencies of every scheduled update
+    std::unique_ptr<std::atomic<int>[]> remainingDependencies;
+    size_t remainingDependenciesCapacity = 0;
+    std::atomic<int> pendingSystems;
+
+    void RunScheduledSystem(int index);
+
+public:
+    SystemScheduler(ThreadPool& threadPool) : threadPool(threadPool), pendingSystems(0) { };
+
+    // Schedules system.Update(args...) for the next Run(). The arguments are captured by reference,
+    // so they must outlive Run().
+    template<typename TSystem, typename... TArgs>
+    void Schedule(TSystem& system, TArgs&... args);
+
+    // Runs the scheduled updates and returns once all of them are done, then clears the schedule
+    void Run();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Registry
+////////////////////////////////////////////////////////////////////////////////
+// The registry manages the creation and destruction of entities, add systems,
+// and components.
+////////////////////////////////////////////////////////////////////////////////
+class Registry
+{
+private:
+    int numEntities = 0;
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Component data grouped by entity signature
+    ArchetypeStorage archetypes;
+#else
+    // Vector of component pools, each pool contains all the data for a certain compoenent type
+    // [Vector index = component type id]
+    // [Pool index = entity id]
+    std::vector<std::shared_ptr<IPool>> componentPools;
+#endif
+
+    // Vector of component signatures per entity, saying which component is turned "on" for a given entity
+    // [Vector index = entity id]
+    std::vector<Signature> entityComponentSignatures;
+
+    // Map of active systems
+    // [Map key = system type id]
+    std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
+
+    // Entities that are flagged to be added or removed in the next registry Update(), sorted by id when processed
+    std::vector<Entity> entitiesToBeAdded;
+    std::vector<Entity> entitiesToBeKilled;
+
+    // Systems running concurrently may kill entities
+    std::mutex entitiesToBeKilledMutex;
+
+    // Tag and group names interned to small ids
+    // [Map key = tag or group name]
+    std::unordered_map<std::string, int> tagIds;
+    std::unordered_map<std::string, int> groupIds;
+
+    // Entity tags (one tag per entity, one entity per tag)
+    // [Vector index = tag id]
+    std::vector<Entity> entityPerTag;
+    // [Vector index = entity id] [Value = tag id, or -1]
+    std::vector<int> tagPerEntity;
+
+    // Vector of group bitsets per entity, next to the component signatures
+    // [Vector index = entity id]
+    std::vector<GroupMask> entityGroupMasks;
+
+    // Systems that require each component, so a signature change only re-checks the affected systems
+    // [Vector index = component type id]
+    std::vector<std::vector<System*>> systemsPerComponent;
+
+    // Systems interested in each entity signature seen so far, most entities share a handful of them.
+    // Cleared whenever systems are added or removed.
+    // [Map key = entity signature]
+    std::unordered_map<Signature, std::vector<System*>> systemsPerSignature;
+
+    // Entities created together usually share a signature, so the last lookup is checked before hashing
+    Signature lastSignature;
+    const std::vector<System*>* systemsForLastSignature = nullptr;
+
+    // Components added to or removed from entities that are already in their systems,
+    // the affected systems are re-checked in the next registry Update()
+    std::vector<std::pair<Entity, int>> signatureChanges;
+
+    // Generation of every entity id. The slots of removed ids also form an intrusive
+    // free list, each one holding the next free id, so ids are recycled without extra storage.
+    // [Vector index = entity id]
+    struct EntitySlot
+    {
+        int generation = 0;
+        int nextFreeId = -1;
+        bool isInSystems = false;
+        bool isPendingKill = false;
+    };
+    std::vector<EntitySlot> entitySlots;
+    int firstFreeId = -1;
+
+    // Command buffers waiting to be applied in the next registry Update(), guarded by a mutex
+    // because they can be submitted from any thread
+    std::vector<CommandBuffer> submittedCommandBuffers;
+    std::mutex submittedCommandBuffersMutex;
+
+    ThreadPool* threadPool = nullptr;
+
+    // Stamped on every component written during a frame, bumped by Update()
+    uint32_t changeVersion = 1;
+
+    // Prefabs registered by name, e.g. the ones defined by level files
+    // [Map key = prefab name]
+    std::unordered_map<std::string, Prefab> prefabs;
+
+#ifndef ECS_ARCHETYPE_STORAGE
+    // Returns the pool of a component type, or nullptr if no entity ever had that component
+    template<typename TComponent>
+    Pool<TComponent>* GetComponentPool() const;
+
+    template<typename TComponent>
+    std::shared_ptr<Pool<TComponent>> GetOrCreateComponentPool();
+#endif
+
+#ifndef ECS_ARCHETYPE_STORAGE
+    // Scratch lists of the entities killed in an Update(), kept to reuse their memory
+    // [Vector index = component type id]
+    std::vector<std::vector<int>> killedEntityIdsPerPool;
+
+    // Owning groups declared with DeclareGroup(). An entity is packed in a group exactly while its signature
+    // contains every required (owned or observed) component.
+    struct ComponentGroupData
+    {
+        Signature owned;
+        Signature observed;
+        Signature required;
+        std::vector<int> ownedComponentIds;
+        int size = 0;
+
+        // Set when the group wanted a component type owned by another group, it is then iterated as a view
+        bool isRejected = false;
+    };
+    std::vector<std::unique_ptr<ComponentGroupData>> componentGroups;
+
+    // Every component type owned or observed by a group
+    Signature groupedComponents;
+#endif
+
+    void RebuildSystemsPerComponent();
+
+    // Systems whose required components are all in the signature, from the cache if it was seen before
+    const std::vector<System*>& GetSystemsForSignature(const Signature& signature);
+
+    // Flags a component change of an entity so its system membership gets updated
+    void OnEntitySignatureChanged(Entity entity, int componentId);
+
+    // Removes the entities of entitiesToBeKilled from the systems and the component storage, and frees their ids
+    void KillPendingEntities();
+
+#ifndef ECS_ARCHETYPE_STORAGE
+    // Declares the group unless it already is
+    void DeclareComponentGroup(const Signature& owned, const Signature& observed);
+
+    // Returns the declared group with these components, or nullptr if there is none
+    const ComponentGroupData* FindComponentGroup(const Signature& owned, const Signature& observed) const;
+
+    void EnterComponentGroup(ComponentGroupData& group, int entityId);
+
+    // Packs the entity into the groups it matches now that it has the added components
+    void EnterComponentGroups(int entityId, const Signature& addedComponents);
+
+    // Takes the entity out of the groups it will no longer match once the components are removed
+    void LeaveComponentGroups(int entityId, const Signature& removedComponents);
+
+    void RebuildComponentGroups();
+#endif
+
+    // Gives the entities of a range of consecutive ids, which have no components yet, the components and group of a prefab
+    void InstantiatePrefab(const Prefab& prefab, int firstEntityId, int count);
+
+    // Dry run of Restore() on a reader past the snapshot header. Checks the sizes, entity ids and component
+    // types of every section without touching the registry, so a rejected blob leaves the world as it was.
+    bool IsRestorable(SnapshotReader reader) const;
+
+public:
+    Registry()
+    {
+#ifdef ECS_ARCHETYPE_STORAGE
+        archetypes.TrackChanges(&changeVersion);
+#endif
+        Logger::Log("Registry constructor called");
+    }
+
+    ~Registry()
+    {
+        Logger::Log("Registry destructor called");
+    }
+
+    // The registry Update() finally processes the entities that are waiting to be added/killed to the systems
+    void Update();
+
+    // Entity management
+    Entity CreateEntity();
+
+    // Creates an entity with the components and group of the prefab, reusing a free id like CreateEntity()
+    Entity Instantiate(const Prefab& prefab);
+
+    // Creates count entities from the prefab. They get a block of consecutive new ids, so every component
+    // storage grows once and is filled in one pass. Returns the entities in id order.
+    std::vector<Entity> Instantiate(const Prefab& prefab, int count);
+
+    // Safe to call from any thread
+    void KillEntity(Entity entity);
+
+    // Queues a command buffer to be applied in the next Update(). Safe to call from any thread,
+    // the buffer is left empty and can be reused. Buffers are applied in submission order, so
+    // systems whose buffers must apply in a fixed order should not run concurrently.
+    void SubmitCommandBuffer(CommandBuffer& buffer);
+
+    // Reserve storage ahead of a known number of new entities or components
+    void ReserveEntities(int count);
+
+    // Prefab management. Registering a name again replaces the prefab.
+    void AddPrefab(const std::string& name, Prefab prefab);
+
+    bool HasPrefab(const std::string& name) const;
+
+    const Prefab& GetPrefab(const std::string& name) const;
+
+    // Writes the whole world (entities, components, tags, groups, pending adds and kills) to a binary blob.
+    // Submitted command buffers are not included. Returns an empty blob if a component type cannot be serialized.
+    std::vector<std::byte> Snapshot() const;
+
+    // Same, overwriting a blob whose capacity is reused (e.g. a checkpoint taken again and again)
+    void Snapshot(std::vector<std::byte>& snapshot) const;
+
+    // Replaces the whole world with a blob from Snapshot(), taken by this registry or by one that stored the same
+    // component types. System membership is rebuilt in entity id order, and command buffers submitted before are
+    // dropped. Returns false if the blob is rejected, in which case the world is left untouched.
+    bool Restore(const std::vector<std::byte>& snapshot);
+
+    template<typename TComponent>
+    void ReserveComponents(int count);
+
+    // Returns true if the handle still refers to a live entity, and not to a recycled id
+    bool IsAlive(Entity entity) const
+    {
+        const int id = entity.GetId();
+        return id >= 0 && static_cast<size_t>(id) < entitySlots.size() && entitySlots[id].generation == entity.GetGeneration();
+    }
+
+    // Returns the handle of the entity currently using an id. Like every handle the registry gives out, it can
+    // change the entity, so it is made from a const registry too. An id out of range (negative, or never
+    // created) gives an invalid handle (id -1), which is never alive.
+    Entity GetEntityById(int entityId) const
+    {
+        const bool isInRange = entityId >= 0 && entityId < static_cast<int>(entitySlots.size());
+        Entity entity = isInRange ? Entity(entityId, entitySlots[entityId].generation) : Entity(-1);
+        entity.registry = const_cast<Registry*>(this);
+        return entity;
+    }
+
+    // Tag management. Names are interned once, the id based calls are the fast path.
+    // Interning a new name is not thread-safe, so concurrently running systems should only look up existing names.
+    int GetTagId(const std::string& tag);
+
+    // Id of a tag name that was already interned, or -1, which no entity has. Never interns, so systems running
+    // concurrently can call it.
+    int FindTagId(const std::string& tag) const;
+
+    void TagEntity(Entity entity, const std::string& tag);
+
+    void TagEntity(Entity entity, int tagId);
+
+    bool EntityHasTag(Entity entity, const std::string& tag) const;
+
+    bool EntityHasTag(Entity entity, int tagId) const
+    {
+        return tagId >= 0 && tagId < static_cast<int>(entityPerTag.size()) && entityPerTag[tagId] == entity;
+    }
+
+    Entity GetEntityByTag(const std::string& tag) const;
+
+    void RemoveEntityTag(Entity entity);
+
+    // Group management. Names are interned once, the id based calls are the fast path (same threading rules as tags).
+    int GetGroupId(const std::string& group);
+
+    // Same as FindTagId(), for groups
+    int FindGroupId(const std::string& group) const;
+
+    void GroupEntity(Entity entity, const std::string& group);
+
+    void GroupEntity(Entity entity, int groupId);
+
+    bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
+
+    bool EntityBelongsToGroup(Entity entity, int groupId) const
+    {
+        // Stale handles share the mask of the slot's current entity, so the generation is checked before the mask
+        return groupId >= 0 && IsAlive(entity) && entityGroupMasks[entity.GetId()].test(groupId);
+    }
+
+    // Empty for a group name that was never used, without interning it
+    std::vector<Entity> GetEntitiesByGroup(const std::string& group) const;
+
+    void RemoveEntityGroup(Entity entity);
+
+    // Component management
+    template<typename TComponent, typename... TArgs>
+    void AddComponent(Entity entity, TArgs&&... args);
+
+    template<typename TComponent>
+    void RemoveComponent(Entity entity);
+
+    template<typename TComponent>
+    bool HasComponent(Entity entity) const;
+
+    // Write access, stamps the component with the current change version
+    template<typename TComponent>
+    TComponent& GetComponent(Entity entity);
+
+    // Read access, leaves the change version alone
+    template<typename TComponent>
+    const TComponent& ReadComponent(Entity entity) const;
+
+    // Change tracking. Components are stamped with the change version whenever they are added or written
+    // (GetComponent(), views with non-const component types), and Update() starts a new version every frame.
+    // A consumer keeps the version it last caught up with, and only visits what changed since then.
+    // Removed components are not reported.
+    uint32_t GetChangeVersion() const
+    {
+        return changeVersion;
+    }
+
+    template<typename TComponent>
+    uint32_t GetComponentVersion(Entity entity) const;
+
+    // Calls func(entity, const component&) for every component of the type stamped with sinceVersion or a later
+    // version. Passing the GetChangeVersion() read before the previous call never misses a change, though
+    // components written after that read in the same frame are visited again.
+    template<typename TComponent, typename TFunc>
+    void ForEachChanged(uint32_t sinceVersion, TFunc&& func);
+
+    // Memory used by the component storage and the entity, tag and group bookkeeping
+    MemoryStats GetMemoryStats() const;
+
+    // Gives back the memory reserved beyond what the registry holds now. Storage may move, so this must not
+    // run while systems or views hold references to components.
+    void ShrinkToFit();
+
+    // Iterate all entities that have the given components
+    template<typename... TComponents>
+    ComponentView<TComponents...> View();
+
+    // Declares an owning group (see ComponentGroup) and packs the entities that already match it. The group
+    // keeps the pools of the owned types sorted, so each should be owned by one group only. Declaring reorders
+    // pools, so it belongs to setup, not to a frame where systems may run concurrently. Declaring an existing
+    // group again does nothing.
+    template<typename... TOwned, typename... TObserved>
+    void DeclareGroup(Observed<TObserved...> observed = {});
+
+    // Iterate an owning group, which must have been declared with DeclareGroup(). The owned types may be const
+    // for read access. Only looks the group up, so systems running concurrently can call it. A group that was not
+    // declared asserts, or logs an error once and iterates as a view when asserts are disabled.
+    template<typename... TOwned, typename... TObserved>
+    ComponentGroup<Observed<TObserved...>, TOwned...> Group(Observed<TObserved...> observed = {});
+
+    // Thread pool used by the parallel iterations, nullptr (the default) runs them serially
+    void SetThreadPool(ThreadPool* threadPool);
+
+    ThreadPool* GetThreadPool() const;
+
+    // Calls func(entity) for every entity of the span (e.g. GetSystemEntities()), in chunks of about
+    // chunkSize on the registry thread pool. Same rules as ComponentView::ParallelForEach().
+    template<typename TFunc>
+    void ParallelForEach(std::span<const Entity> entities, int chunkSize, TFunc&& func);
+
+    // System management
+    template<typename TSystem, typename... TArgs>
+    void AddSystem(TArgs&&... args);
+
+    template<typename TSystem>
+    void RemoveSystem();
+
+    template<typename TSystem>
+    bool HasSystem() const;
+
+    template<typename TSystem>
+    TSystem& GetSystem() const;
+
+    // Add and remove entities from their systems
+    void AddEntityToSystems(Entity entity);
+
+    void RemoveEntityFromSystems(Entity entity);
+
+    // Adds or removes the entity from the systems that require the component, after its signature changed
+    void UpdateEntitySystems(Entity entity, int componentId);
+};
+
+template<typename TComponent>
+void System::RequireComponent()
+{
+    const auto componentId = Component<TComponent>::GetId();
+    componentSignature.set(componentId);
+}
+
+template<typename TComponent>
+void System::ReadsComponent()
+{
+    readSignature.set(Component<TComponent>::GetId());
+    declaresComponentAccess = true;
+}
+
+template<typename TComponent>
+void System::WritesComponent()
+{
+    writeSignature.set(Component<TComponent>::GetId());
+    declaresComponentAccess = true;
+}
+
+template<typename TSystem, typename... TArgs>
+void Registry::AddSystem(TArgs&&... args)
+{
+    std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
+    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+    RebuildSystemsPerComponent();
+}
+
+template<typename TSystem>
+void Registry::RemoveSystem()
+{
+    auto system = systems.find(std::type_index(typeid(TSystem)));
+    systems.erase(system);
+    RebuildSystemsPerComponent();
+}
+
+template<typename TSystem>
+bool Registry::HasSystem() const
+{
+    return systems.find(std::type_index(typeid(TSystem))) != systems.end();
+}
+
+template<typename TSystem>
+TSystem& Registry::GetSystem() const
+{
+    auto system = systems.find(std::type_index(typeid(TSystem)));
+    return *(std::static_pointer_cast<TSystem>(system->second));
+}
+
+template<typename TComponent, typename... TArgs>
+void Registry::AddComponent(Entity entity, TArgs&&... args)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    archetypes.Emplace<TComponent>(entityId, std::forward<TArgs>(args)...);
+#else
+    std::shared_ptr<Pool<TComponent>> componentPool = GetOrCreateComponentPool<TComponent>();
+
+    componentPool->Emplace(entityId, std::forward<TArgs>(args)...);
+#endif
+
+    if (!entityComponentSignatures[entityId].test(componentId))
+    {
+        entityComponentSignatures[entityId].set(componentId);
+        OnEntitySignatureChanged(entity, componentId);
+
+#ifndef ECS_ARCHETYPE_STORAGE
+        if (groupedComponents.test(componentId))
+        {
+            Signature addedComponents;
+            addedComponents.set(componentId);
+            EnterComponentGroups(entityId, addedComponents);
+        }
+#endif
+    }
+
+    Logger::Log(
+        "Component id = " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId));
+}
+
+template<typename TComponent>
+void Registry::RemoveComponent(Entity entity)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+
+    // Remove the component from the component list for that entity
+#ifdef ECS_ARCHETYPE_STORAGE
+    archetypes.Remove<TComponent>(entityId);
+#else
+    if (groupedComponents.test(componentId))
+    {
+        Signature removedComponents;
+        removedComponents.set(componentId);
+        LeaveComponentGroups(entityId, removedComponents);
+    }
+
+    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(
+        componentPools[componentId]);
+    componentPool->Remove(entityId);
+#endif
+
+    // Set this component signature for that entity to false
+    entityComponentSignatures[entityId].set(componentId, false);
+    OnEntitySignatureChanged(entity, componentId);
+
+    Logger::Log(
+        "Component id = " + std::to_string(componentId) + " was removed from entity id " + std::to_string(entityId));
+}
+
+template<typename TComponent>
+bool Registry::HasComponent(Entity entity) const
+{
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+    return entityComponentSignatures[entityId].test(componentId);
+}
+
+template<typename TComponent>
+TComponent& Registry::GetComponent(Entity entity)
+{
+    const auto entityId = entity.GetId();
+#ifdef ECS_ARCHETYPE_STORAGE
+    return archetypes.Get<TComponent>(entityId);
+#else
+    // Raw pool pointer: systems running concurrently would otherwise contend on the shared_ptr reference count
+    return GetComponentPool<TComponent>()->Get(entityId);
+#endif
+}
+
+template<typename TComponent>
+const TComponent& Registry::ReadComponent(Entity entity) const
+{
+    const auto entityId = entity.GetId();
+#ifdef ECS_ARCHETYPE_STORAGE
+    return archetypes.Read<TComponent>(entityId);
+#else
+    return GetComponentPool<TComponent>()->Read(entityId);
+#endif
+}
+
+template<typename TComponent>
+uint32_t Registry::GetComponentVersion(Entity entity) const
+{
+#ifdef ECS_ARCHETYPE_STORAGE
+    return archetypes.GetVersion(Component<TComponent>::GetId(), entity.GetId());
+#else
+    return GetComponentPool<TComponent>()->GetVersion(entity.GetId());
+#endif
+}
+
+#ifdef ECS_ARCHETYPE_STORAGE
+template<typename TComponent>
+void Registry::ReserveComponents(int)
+{
+    // Archetype chunks are allocated as entities move in, only the type needs to be known
+    archetypes.RegisterComponent<TComponent>();
+}
+
+template<typename... TComponents>
+ComponentView<TComponents...> Registry::View()
+{
+    return ComponentView<TComponents...>(this, &archetypes);
+}
+
+template<typename... TOwned, typename... TObserved>
+void Registry::DeclareGroup(Observed<TObserved...>)
+{
+    // Archetype chunks already keep the components of an entity together, there is nothing to pack
+}
+
+template<typename... TOwned, typename... TObserved>
+ComponentGroup<Observed<TObserved...>, TOwned...> Registry::Group(Observed<TObserved...>)
+{
+    return ComponentGroup<Observed<TObserved...>, TOwned...>(this, &archetypes);
+}
+
+template<typename TComponent, typename TFunc>
+void Registry::ForEachChanged(uint32_t sinceVersion, TFunc&& func)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    Signature signature;
+    signature.set(componentId);
+
+    archetypes.ForEachArchetype(signature, [&](const Archetype& archetype)
+    {
+        for (int chunk = 0; chunk < archetype.GetChunkCount(); chunk++)
+        {
+            const int* entityIds = archetype.GetChunkEntityIds(chunk);
+            const TComponent* components = archetype.GetChunkColumn<const TComponent>(chunk);
+            for (int row = 0; row < archetype.GetChunkEntityCount(chunk); row++)
+            {
+                if (archetypes.GetVersion(componentId, entityIds[row]) >= sinceVersion)
+                {
+                    func(GetEntityById(entityIds[row]), components[row]);
+                }
+            }
+        }
+    });
+}
+
+template<typename... TComponents>
+template<typename TFunc>
+void ComponentView<TComponents...>::Invoke(TFunc& func, int entityId, TComponents*... components) const
+{
+    (MarkWritten<TComponents>(entityId), ...);
+
+    if constexpr (std::is_invocable_v<TFunc, Entity, TComponents&...>)
+    {
+        func(registry->GetEntityById(entityId), *components...);
+    }
+    else
+    {
+        func(*components...);
+    }
+}
+
+template<typename... TComponents>
+template<typename TComponent>
+void ComponentView<TComponents...>::MarkWritten(int entityId) const
+{
+    if constexpr (!std::is_const_v<TComponent>)
+    {
+        storage->MarkChanged(Component<TComponent>::GetId(), entityId);
+    }
+}
+
+template<typename... TComponents>
+template<typename TFunc>
+void ComponentView<TComponents...>::ForEachChunk(TFunc&& func) const
+{
+    Signature viewSignature;
+    (viewSignature.set(Component<std::remove_const_t<TComponents>>::GetId()), ...);
+
+    storage->ForEachArchetype(viewSignature, [&](const Archetype& archetype)
+    {
+        for (int chunk = 0; chunk < archetype.GetChunkCount(); chunk++)
+        {
+            func(archetype, chunk);
+        }
+    });
+}
+
+template<typename... TComponents>
+template<typename TFunc>
+void ComponentView<TComponents...>::Each(TFunc&& func) const
+{
+    // Every matching archetype is walked chunk by chunk, reading each component column linearly
+    ForEachChunk([&](const Archetype& archetype, int chunk)
+    {
+        const int count = archetype.GetChunkEntityCount(chunk);
+        const int* entityIds = archetype.GetChunkEntityIds(chunk);
+        const auto columns = std::make_tuple(archetype.GetChunkColumn<TComponents>(chunk)...);
+
+        for (int row = 0; row < count; row++)
+        {
+            Invoke(func, entityIds[row], (std::get<TComponents*>(columns) + row)...);
+        }
+    });
+}
+
+template<typename... TComponents>
+template<typename TFunc>
+void ComponentView<TComponents...>::ParallelForEach(int chunkSize, TFunc&& func) const
+{
+    // Archetype chunks are cut into row ranges of chunkSize, which become the parallel work items
+    struct RowRange
+    {
+        const Archetype* archetype;
+        int chunk;
+        int begin;
+        int end;
+    };
+    std::vector<RowRange> rowRanges;
+    chunkSize = std::max(chunkSize, 1);
+    ForEachChunk([&](const Archetype& archetype, int chunk)
+    {
+        const int count = archetype.GetChunkEntityCount(chunk);
+        for (int begin = 0; begin < count; begin += chunkSize)
+        {
+            rowRanges.push_back({ &archetype, chunk, begin, std::min(begin + chunkSize, count) });
+        }
+    });
+
+    auto runRowRanges = [&](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+        {
+            const RowRange& range = rowRanges[i];
+            const Archetype* archetype = range.archetype;
+            const int* entityIds = archetype->GetChunkEntityIds(range.chunk);
+            const auto columns = std::make_tuple(archetype->GetChunkColumn<TComponents>(range.chunk)...);
+
+            for (int row = range.begin; row < range.end; row++)
+            {
+                Invoke(func, entityIds[row], (std::get<TComponents*>(columns) + row)...);
+            }
+        }
+    };
+
+    ThreadPool* threadPool = registry->GetThreadPool();
+    if (threadPool)
+    {
+        threadPool->ParallelFor(static_cast<int>(rowRanges.size()), 1, runRowRanges);
+    }
+    else
+    {
+        runRowRanges(0, static_cast<int>(rowRanges.size()));
+    }
+}
+
+template<typename... TObserved, typename... TOwned>
+template<typename TFunc>
+void ComponentGroup<Observed<TObserved...>, TOwned...>::Each(TFunc&& func) const
+{
+    view.Each(std::forward<TFunc>(func));
+}
+
+template<typename... TObserved, typename... TOwned>
+template<typename TFunc>
+void ComponentGroup<Observed<TObserved...>, TOwned...>::ParallelForEach(int chunkSize, TFunc&& func) const
+{
+    view.ParallelForEach(chunkSize, std::forward<TFunc>(func));
+}
+#else
+template<typename TComponent>
+void Registry::ReserveComponents(int count)
+{
+    auto componentPool = GetOrCreateComponentPool<TComponent>();
+    componentPool->Reserve(componentPool->GetSize() + count);
+}
+
+template<typename TComponent>
+Pool<TComponent>* Registry::GetComponentPool() const
+{
+    const auto componentId = Component<TComponent>::GetId();
+    if (componentId >= static_cast<int>(componentPools.size()))
+    {
+        return nullptr;
+    }
+    return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template<typename TComponent>
+std::shared_ptr<Pool<TComponent>> Registry::GetOrCreateComponentPool()
+{
+    const auto componentId = Component<TComponent>::GetId();
+
+    if (componentId >= static_cast<int>(componentPools.size()))
     {
-        Logger::Log("Registry constructor called");
+        componentPools.resize(componentId + 1, nullptr);
     }
 
-    ~Registry()
+    if (!componentPools[componentId])
     {
-        Logger::Log("Registry destructor called");
+        std::shared_ptr<Pool<TComponent>> newComponentPool(new Pool<TComponent>());
+        newComponentPool->TrackChanges(&changeVersion);
+        componentPools[componentId] = newComponentPool;
     }
 
-    // The registry Update() finally processes the entities that are waiting to be added/killed to the systems
-    void Update();
-
-    // Entity management
-    Entity CreateEntity();
+    return std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+}
 
-    void KillEntity(Entity entity);
+template<typename... TComponents>
+ComponentView<TComponents...> Registry::View()
+{
+    return ComponentView<TComponents...>(this, GetComponentPool<std::remove_const_t<TComponents>>()...);
+}
 
-    // Tag management
-    void TagEntity(Entity entity, const std::string& tag);
+template<typename... TOwned, typename... TObserved>
+void Registry::DeclareGroup(Observed<TObserved...>)
+{
+    // The pools are created up front, so the group can be packed before any entity has the components
+    Signature owned;
+    Signature observed;
+    (owned.set(Component<std::remove_const_t<TOwned>>::GetId()), ...);
+    (observed.set(Component<std::remove_const_t<TObserved>>::GetId()), ...);
+    (GetOrCreateComponentPool<std::remove_const_t<TOwned>>(), ...);
+    (GetOrCreateComponentPool<std::remove_const_t<TObserved>>(), ...);
+
+    DeclareComponentGroup(owned, observed);
+}
 
-    bool EntityHasTag(Entity entity, const std::string& tag) const;
+template<typename... TOwned, typename... TObserved>
+ComponentGroup<Observed<TObserved...>, TOwned...> Registry::Group(Observed<TObserved...>)
+{
+    Signature owned;
+    Signature observed;
+    (owned.set(Component<std::remove_const_t<TOwned>>::GetId()), ...);
+    (observed.set(Component<std::remove_const_t<TObserved>>::GetId()), ...);
+
+    // A rejected group, or one that was never declared, iterates as a view. Declaring it here would reorder pools
+    // under systems that may be running, so a missing declaration is reported once per group type instead.
+    const ComponentGroupData* group = FindComponentGroup(owned, observed);
+    if (!group)
+    {
+        static std::once_flag isReported;
+        std::call_once(isReported, []()
+        {
+            Logger::Err("Component group iterated without Registry::DeclareGroup(), it will be iterated as a view");
+        });
+    }
+    assert(group && "Component groups must be declared with Registry::DeclareGroup() before they are iterated");
+    const int* size = group && !group->isRejected ? &group->size : nullptr;
+    return ComponentGroup<Observed<TObserved...>, TOwned...>(this, GetComponentPool<std::remove_const_t<TOwned>>()...,
+        GetComponentPool<std::remove_const_t<TObserved>>()..., size);
+}
 
-    Entity GetEntityByTag(const std::string& tag) const;
+template<typename TComponent, typename TFunc>
+void Registry::ForEachChanged(uint32_t sinceVersion, TFunc&& func)
+{
+    const Pool<TComponent>* componentPool = GetComponentPool<TComponent>();
+    if (!componentPool)
+    {
+        return;
+    }
 
-    void RemoveEntityTag(Entity entity);
+    // The versions are packed like the components, so this is a linear scan of one array
+    const auto& entityIds = componentPool->GetEntityIds();
+    const auto& versions = componentPool->GetVersions();
+    for (size_t i = 0; i < versions.size(); i++)
+    {
+        if (versions[i] >= sinceVersion)
+        {
+            func(GetEntityById(entityIds[i]), componentPool->Read(entityIds[i]));
+        }
+    }
+}
 
-    // Group management
-    void GroupEntity(Entity entity, const std::string& group);
+template<typename... TComponents>
+template<typename TFunc>
+void ComponentView<TComponents...>::Invoke(TFunc& func, int entityId) const
+{
+    if constexpr (std::is_invocable_v<TFunc, Entity, TComponents&...>)
+    {
+        func(registry->GetEntityById(entityId), Fetch<TComponents>(entityId)...);
+    }
+    else
+    {
+        func(Fetch<TComponents>(entityId)...);
+    }
+}
 
-    bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
+template<typename... TComponents>
+template<typename TComponent>
+TComponent& ComponentView<TComponents...>::Fetch(int entityId) const
+{
+    if constexpr (std::is_const_v<TComponent>)
+    {
+        return GetPool<TComponent>()->Read(entityId);
+    }
+    else
+    {
+        return GetPool<TComponent>()->Get(entityId);
+    }
+}
 
-    std::vector<Entity> GetEntitiesByGroup(const std::string& group) const;
+template<typename... TComponents>
+const std::vector<int>* ComponentView<TComponents...>::GetSmallestEntityIds() const
+{
+    // A component type that was never added means no entity can match
+    if ((!GetPool<TComponents>() || ...))
+    {
+        return nullptr;
+    }
 
-    void RemoveEntityGroup(Entity entity);
+    // Drive the iteration with the smallest pool, and probe the others with O(1) lookups
+    const std::vector<int>* entityIds = nullptr;
+    ((entityIds = (!entityIds || GetPool<TComponents>()->GetEntityIds().size() < entityIds->size())
+        ? &GetPool<TComponents>()->GetEntityIds()
+        : entityIds), ...);
+    return entityIds;
+}
 
-    // Component management
-    template<typename TComponent, typename... TArgs>
-    void AddComponent(Entity entity, TArgs&&... args);
+template<typename... TComponents>
+template<typename TFunc>
+void ComponentView<TComponents...>::Each(TFunc&& func) const
+{
+    const std::vector<int>* entityIds = GetSmallestEntityIds();
+    if (!entityIds)
+    {
+        return;
+    }
 
-    template<typename TComponent>
-    void RemoveComponent(Entity entity);
+    for (size_t i = 0; i < entityIds->size(); i++)
+    {
+        const int entityId = (*entityIds)[i];
 
-    template<typename TComponent>
-    bool HasComponent(Entity entity) const;
+        if (!(GetPool<TComponents>()->Has(entityId) && ...))
+        {
+            continue;
+        }
 
-    template<typename TComponent>
-    TComponent& GetComponent(Entity entity) const;
+        Invoke(func, entityId);
+    }
+}
 
-    // System management
-    template<typename TSystem, typename... TArgs>
-    void AddSystem(TArgs&&... args);
+template<typename... TComponents>
+template<typename TFunc>
+void ComponentView<TComponents...>::ParallelForEach(int chunkSize, TFunc&& func) const
+{
+    const std::vector<int>* entityIds = GetSmallestEntityIds();
+    if (!entityIds)
+    {
+        return;
+    }
 
-    template<typename TSystem>
-    void RemoveSystem();
+    auto runEntities = [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const int entityId = (*entityIds)[i];
 
-    template<typename TSystem>
-    bool HasSystem() const;
+            if (!(GetPool<TComponents>()->Has(entityId) && ...))
+            {
+                continue;
+            }
 
-    template<typename TSystem>
-    TSystem& GetSystem() const;
+            Invoke(func, entityId);
+        }
+    };
 
-    // Add and remove entities from their systems
-    void AddEntityToSystems(Entity entity);
+    ThreadPool* threadPool = registry->GetThreadPool();
+    if (threadPool)
+    {
+        threadPool->ParallelFor(static_cast<int>(entityIds->size()), chunkSize, runEntities);
+    }
+    else
+    {
+        runEntities(0, static_cast<int>(entityIds->size()));
+    }
+}
 
-    void RemoveEntityFromSystems(Entity entity);
-};
+template<typename... TObserved, typename... TOwned>
+template<typename TFunc>
+void ComponentGroup<Observed<TObserved...>, TOwned...>::Invoke(TFunc& func, int index, int entityId) const
+{
+    if constexpr (std::is_invocable_v<TFunc, Entity, TOwned&..., TObserved&...>)
+    {
+        func(registry->GetEntityById(entityId), FetchOwned<TOwned>(index)..., FetchObserved<TObserved>(entityId)...);
+    }
+    else
+    {
+        func(FetchOwned<TOwned>(index)..., FetchObserved<TObserved>(entityId)...);
+    }
+}
 
+template<typename... TObserved, typename... TOwned>
 template<typename TComponent>
-void System::RequireComponent()
+TComponent& ComponentGroup<Observed<TObserved...>, TOwned...>::FetchOwned(int index) const
 {
-    const auto componentId = Component<TComponent>::GetId();
-    componentSignature.set(componentId);
+    auto* pool = std::get<Pool<std::remove_const_t<TComponent>>*>(ownedPools);
+    if constexpr (std::is_const_v<TComponent>)
+    {
+        return pool->ReadAt(index);
+    }
+    else
+    {
+        return (*pool)[index];
+    }
 }
 
-template<typename TSystem, typename... TArgs>
-void Registry::AddSystem(TArgs&&... args)
+template<typename... TObserved, typename... TOwned>
+template<typename TComponent>
+TComponent& ComponentGroup<Observed<TObserved...>, TOwned...>::FetchObserved(int entityId) const
 {
-    std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
-    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+    auto* pool = std::get<Pool<std::remove_const_t<TComponent>>*>(observedPools);
+    if constexpr (std::is_const_v<TComponent>)
+    {
+        return pool->Read(entityId);
+    }
+    else
+    {
+        return pool->Get(entityId);
+    }
 }
 
-template<typename TSystem>
-void Registry::RemoveSystem()
+template<typename... TObserved, typename... TOwned>
+template<typename TFunc>
+void ComponentGroup<Observed<TObserved...>, TOwned...>::Each(TFunc&& func) const
 {
-    auto system = systems.find(std::type_index(typeid(TSystem)));
-    systems.erase(system);
+    if (!size)
+    {
+        view.Each(std::forward<TFunc>(func));
+        return;
+    }
+
+    // The first *size elements of every owned pool belong to the same entities, in the same order
+    const int count = *size;
+    const int* entityIds = std::get<0>(ownedPools)->GetEntityIds().data();
+    for (int i = 0; i < count; i++)
+    {
+        Invoke(func, i, entityIds[i]);
+    }
 }
 
-template<typename TSystem>
-bool Registry::HasSystem() const
+template<typename... TObserved, typename... TOwned>
+template<typename TFunc>
+void ComponentGroup<Observed<TObserved...>, TOwned...>::ParallelForEach(int chunkSize, TFunc&& func) const
 {
-    return systems.find(std::type_index(typeid(TSystem))) != systems.end();
+    if (!size)
+    {
+        view.ParallelForEach(chunkSize, std::forward<TFunc>(func));
+        return;
+    }
+
+    const int count = *size;
+    const int* entityIds = std::get<0>(ownedPools)->GetEntityIds().data();
+    auto runEntities = [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            Invoke(func, i, entityIds[i]);
+        }
+    };
+
+    ThreadPool* threadPool = registry->GetThreadPool();
+    if (threadPool)
+    {
+        threadPool->ParallelFor(count, chunkSize, runEntities);
+    }
+    else
+    {
+        runEntities(0, count);
+    }
 }
+#endif
 
-template<typename TSystem>
-TSystem& Registry::GetSystem() const
+template<typename TComponent>
+TComponent* Archetype::GetChunkColumn(int chunk) const
 {
-    auto system = systems.find(std::type_index(typeid(TSystem)));
-    return *(std::static_pointer_cast<TSystem>(system->second));
+    const int column = columnPerComponent[Component<std::remove_const_t<TComponent>>::GetId()];
+    return reinterpret_cast<TComponent*>(chunks[chunk]->memory + columnOffsets[column]);
 }
 
-template<typename TComponent, typename... TArgs>
-void Registry::AddComponent(Entity entity, TArgs&&... args)
+template<typename TComponent>
+void ArchetypeStorage::RegisterComponent()
 {
     const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
+    if (componentId >= static_cast<int>(componentInfos.size()))
+    {
+        componentInfos.resize(componentId + 1);
+    }
 
-    if (componentId >= componentPools.size())
+    if (componentId >= static_cast<int>(versions.size()))
     {
-        componentPools.resize(componentId + 1, nullptr);
+        versions.resize(componentId + 1);
     }
 
-    if (!componentPools[componentId])
+    auto& info = componentInfos[componentId];
+    if (info.size == 0)
     {
-        std::shared_ptr<Pool<TComponent>> newComponentPool(new Pool<TComponent>());
-        componentPools[componentId] = newComponentPool;
+        info.size = sizeof(TComponent);
+        info.alignment = alignof(TComponent);
+        info.name = Component<TComponent>::GetName().c_str();
+        info.moveConstruct = [](void* destination, void* source)
+        {
+            new (destination) TComponent(std::move(*static_cast<TComponent*>(source)));
+        };
+        info.destroy = [](void* object)
+        {
+            static_cast<TComponent*>(object)->~TComponent();
+        };
+        if constexpr (std::is_trivially_copyable_v<TComponent>)
+        {
+            info.serialize = [](SnapshotWriter& writer, const void* objects, int count)
+            {
+                writer.WriteBytes(objects, count * sizeof(TComponent));
+            };
+            info.deserialize = [](SnapshotReader& reader, void* objects, int count)
+            {
+                reader.ReadBytes(objects, count * sizeof(TComponent));
+            };
+        }
+        else if constexpr (SerializableComponent<TComponent>)
+        {
+            info.serialize = [](SnapshotWriter& writer, const void* objects, int count)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    static_cast<const TComponent*>(objects)[i].Serialize(writer);
+                }
+            };
+            info.deserialize = [](SnapshotReader& reader, void* objects, int count)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    std::construct_at(static_cast<TComponent*>(objects) + i)->Deserialize(reader);
+                }
+            };
+        }
     }
+}
 
-    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(
-        componentPools[componentId]);
+template<typename TComponent, typename... TArgs>
+void ArchetypeStorage::Emplace(int entityId, TArgs&&... args)
+{
+    RegisterComponent<TComponent>();
+
+    const auto componentId = Component<TComponent>::GetId();
+    if (entityId >= static_cast<int>(locations.size()))
+    {
+        locations.resize(entityId + 1);
+    }
 
-    TComponent newComponent(std::forward<TArgs>(args)...);
+    Archetype* current = locations[entityId].archetype;
+    if (current && current->HasComponent(componentId))
+    {
+        // If the entity already has the component, simply replace the component object
+        Get<TComponent>(entityId) = TComponent(std::forward<TArgs>(args)...);
+        return;
+    }
 
-    componentPool->Set(entityId, newComponent);
+    // Construct the new component in place in the archetype that also has it, before the old row goes
+    // away, since the arguments may still reference components of the entity
+    Archetype* target = GetNeighbour(current, componentId, true);
+    const int targetRow = target->Allocate(entityId);
+    new (target->GetComponent(componentId, targetRow)) TComponent(std::forward<TArgs>(args)...);
+    MoveEntity(entityId, target, targetRow);
+    StampAddedComponent(componentId, entityId);
+}
 
-    entityComponentSignatures[entityId].set(componentId);
+template<typename TComponent>
+void ArchetypeStorage::Remove(int entityId)
+{
+    const auto componentId = Component<TComponent>::GetId();
+    Archetype* target = GetNeighbour(locations[entityId].archetype, componentId, false);
 
-    Logger::Log(
-        "Component id = " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId));
+    if (target)
+    {
+        MoveEntity(entityId, target, target->Allocate(entityId));
+    }
+    else
+    {
+        // That was the last component of the entity
+        RemoveFromArchetype(entityId);
+    }
 }
 
 template<typename TComponent>
-void Registry::RemoveComponent(Entity entity)
+TComponent& ArchetypeStorage::Get(int entityId)
 {
     const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
+    const auto& location = locations[entityId];
+    MarkChanged(componentId, entityId);
+    return *static_cast<TComponent*>(location.archetype->GetComponent(componentId, location.row));
+}
 
-    // Remove the component from the component list for that entity
-    std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(
-        componentPools[componentId]);
-    componentPool->Remove(entityId);
+template<typename TComponent>
+const TComponent& ArchetypeStorage::Read(int entityId) const
+{
+    const auto& location = locations[entityId];
+    return *static_cast<const TComponent*>(location.archetype->GetComponent(Component<TComponent>::GetId(), location.row));
+}
 
-    // Set this component signature for that entity to false
-    entityComponentSignatures[entityId].set(componentId, false);
+template<typename TFunc>
+void ArchetypeStorage::ForEachArchetype(const Signature& signature, TFunc&& func) const
+{
+    for (const Archetype* archetype : archetypeList)
+    {
+        if (archetype->GetSize() > 0 && archetype->GetSignature().Contains(signature))
+        {
+            func(*archetype);
+        }
+    }
+}
 
-    Logger::Log(
-        "Component id = " + std::to_string(componentId) + " was removed from entity id " + std::to_string(entityId));
+template<typename TComponent, typename... TArgs>
+void CommandBuffer::AddComponent(Entity entity, TArgs&&... args)
+{
+    AddComponentReservation(Component<TComponent>::GetId(), [](Registry& registry, int count)
+    {
+        registry.ReserveComponents<TComponent>(count);
+    });
+
+    commands.emplace_back([entity, arguments = std::make_tuple(std::forward<TArgs>(args)...)](Registry& registry, CommandBuffer& buffer) mutable
+    {
+        const Entity target = buffer.Resolve(entity);
+        std::apply([&](auto&... values)
+        {
+            registry.AddComponent<TComponent>(target, std::move(values)...);
+        }, arguments);
+    });
 }
 
 template<typename TComponent>
-bool Registry::HasComponent(Entity entity) const
+void CommandBuffer::RemoveComponent(Entity entity)
 {
-    const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
-    return entityComponentSignatures[entityId].test(componentId);
+    commands.emplace_back([entity](Registry& registry, CommandBuffer& buffer)
+    {
+        registry.RemoveComponent<TComponent>(buffer.Resolve(entity));
+    });
 }
 
-template<typename TComponent>
-TComponent& Registry::GetComponent(Entity entity) const
+template<typename TComponent, typename... TArgs>
+Prefab& Prefab::AddComponent(TArgs&&... args)
 {
     const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
-    auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-    return componentPool->Get(entityId);
+
+    ComponentDefault component;
+    component.componentId = componentId;
+    component.value = std::make_shared<const TComponent>(std::forward<TArgs>(args)...);
+    component.reserveComponents = [](Registry& registry, int count)
+    {
+        registry.ReserveComponents<TComponent>(count);
+    };
+#ifdef ECS_ARCHETYPE_STORAGE
+    component.registerComponent = [](ArchetypeStorage& storage)
+    {
+        storage.RegisterComponent<TComponent>();
+    };
+    component.copyConstruct = [](void* destination, const void* value)
+    {
+        new (destination) TComponent(*static_cast<const TComponent*>(value));
+    };
+#else
+    component.createPool = []() -> std::shared_ptr<IPool>
+    {
+        return std::make_shared<Pool<TComponent>>();
+    };
+    component.appendCopies = [](IPool& pool, int firstEntityId, int count, const void* value)
+    {
+        static_cast<Pool<TComponent>&>(pool).AppendCopies(firstEntityId, count, *static_cast<const TComponent*>(value));
+    };
+#endif
+
+    auto position = std::lower_bound(components.begin(), components.end(), componentId, [](const ComponentDefault& component, int componentId)
+    {
+        return component.componentId < componentId;
+    });
+    if (position != components.end() && position->componentId == componentId)
+    {
+        *position = std::move(component);
+    }
+    else
+    {
+        components.insert(position, std::move(component));
+    }
+    signature.set(componentId);
+    return *this;
+}
+
+template<typename TFunc>
+void Registry::ParallelForEach(std::span<const Entity> entities, int chunkSize, TFunc&& func)
+{
+    auto runEntities = [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            func(entities[i]);
+        }
+    };
+
+    if (threadPool)
+    {
+        threadPool->ParallelFor(static_cast<int>(entities.size()), chunkSize, runEntities);
+    }
+    else
+    {
+        runEntities(0, static_cast<int>(entities.size()));
+    }
+}
+
+template<typename TSystem, typename... TArgs>
+void SystemScheduler::Schedule(TSystem& system, TArgs&... args)
+{
+    scheduledSystems.push_back({ &system, [&system, &args...]() { system.Update(args...); }, {}, 0 });
 }
 
 template<typename TComponent, typename... TArgs>
@@ -476,4 +2748,10 @@ TComponent& Entity::GetComponent() const
     return registry->GetComponent<TComponent>(*this);
 }
 
+template<typename TComponent>
+const TComponent& Entity::ReadComponent() const
+{
+    return registry->ReadComponent<TComponent>(*this);
+}
+
 #endif
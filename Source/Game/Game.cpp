@@ -49,6 +49,9 @@ Game::Game() : isRunning(false), isDebug(false), millisecondsPreviousFrame(0)
     registry = std::make_unique<Registry>();
     assetStore = std::make_unique<AssetStore>();
     eventBus = std::make_unique<EventBus>();
+    threadPool = std::make_unique<ThreadPool>();
+    systemScheduler = std::make_unique<SystemScheduler>(*threadPool);
+    registry->SetThreadPool(threadPool.get());
 
     Logger::Log("Game constructor called!");
 }
@@ -126,6 +129,10 @@ void Game::Setup()
     registry->AddSystem<RenderHealthBarSystem>();
     registry->AddSystem<RenderGUISystem>();
 
+    // Owning groups reorder pools when declared, so they are declared here rather than while systems run
+    registry->GetSystem<RenderSystem>().DeclareComponentGroups(registry);
+    registry->GetSystem<MovementSystem>().DeclareComponentGroups(registry);
+
     LevelLoader loader;
     lua.open_libraries(sol::lib::base, sol::lib::math);
     loader.LoadLevel(lua, registry, assetStore, renderer, 1);
@@ -201,12 +208,14 @@ void Game::Update()
 
     registry->Update();
 
-    registry->GetSystem<MovementSystem>().Update(deltaTime);
-    registry->GetSystem<AnimationSystem>().Update();
-    registry->GetSystem<CollisionSystem>().Update(eventBus);
-    registry->GetSystem<CameraMovementSystem>().Update(camera);
-    registry->GetSystem<ProjectileEmitSystem>().Update(registry);
-    registry->GetSystem<ProjectileLifecycleSystem>().Update();
+    // Systems are scheduled in their serial order, the ones that don't share components run concurrently
+    systemScheduler->Schedule(registry->GetSystem<MovementSystem>(), registry, deltaTime);
+    systemScheduler->Schedule(registry->GetSystem<AnimationSystem>());
+    systemScheduler->Schedule(registry->GetSystem<CollisionSystem>(), registry, eventBus);
+    systemScheduler->Schedule(registry->GetSystem<CameraMovementSystem>(), camera);
+    systemScheduler->Schedule(registry->GetSystem<ProjectileEmitSystem>(), registry);
+    systemScheduler->Schedule(registry->GetSystem<ProjectileLifecycleSystem>());
+    systemScheduler->Run();
 }
 
 void Game::Render()
@@ -214,13 +223,13 @@ void Game::Render()
     SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255);
     SDL_RenderClear(renderer);
 
-    registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera);
+    registry->GetSystem<RenderSystem>().Update(registry, renderer, assetStore, camera);
     registry->GetSystem<RenderTextSystem>().Update(renderer, assetStore, camera);
     registry->GetSystem<RenderHealthBarSystem>().Update(renderer, assetStore, camera);
 
     if (isDebug)
     {
-        registry->GetSystem<RenderColliderSystem>().Update(renderer, camera);
+        registry->GetSystem<RenderColliderSystem>().Update(registry, renderer, camera);
         registry->GetSystem<RenderGUISystem>().Update(registry, camera);
     }
 
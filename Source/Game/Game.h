@@ -6,6 +6,7 @@
 #include "../ECS/ECS.h"
 #include "../AssetStore/AssetStore.h"
 #include "../EventBus/EventBus.h"
+#include "../ThreadPool/ThreadPool.h"
 #include "sol/sol.hpp"
 
 
@@ -28,6 +29,8 @@ private:
 	std::unique_ptr<Registry> registry;
 	std::unique_ptr<AssetStore> assetStore;
 	std::unique_ptr<EventBus> eventBus;
+	std::unique_ptr<ThreadPool> threadPool;
+	std::unique_ptr<SystemScheduler> systemScheduler;
 
 public:
 	static int windowWidth;
@@ -22,6 +22,182 @@
 #include "../Components/HealthComponent.h"
 #include "../Components/TextLabelComponent.h"
 #include "../Components/BoxColliderComponent.h"
+#include "../Systems/CollisionSystem.h"
+
+// Layer names usable in the layer and mask of a Lua boxcollider table
+static const std::pair<const char*, uint32_t> COLLISION_LAYER_NAMES[] = {
+    { "default", COLLISION_LAYER_DEFAULT },
+    { "player", COLLISION_LAYER_PLAYER },
+    { "enemies", COLLISION_LAYER_ENEMIES },
+    { "projectiles", COLLISION_LAYER_PROJECTILES },
+    { "obstacles", COLLISION_LAYER_OBSTACLES },
+    { "all", COLLISION_LAYER_ALL }
+};
+
+// Collision layer bits from a Lua value: raw bits as a number, a layer name, or a list of either
+static uint32_t GetCollisionLayers(const sol::object& value, uint32_t defaultLayers)
+{
+    if (value.is<sol::table>())
+    {
+        uint32_t layers = 0;
+        for (const auto& [key, element] : value.as<sol::table>())
+        {
+            layers |= GetCollisionLayers(element, 0);
+        }
+        return layers;
+    }
+
+    if (value.get_type() == sol::type::number)
+    {
+        return value.as<uint32_t>();
+    }
+
+    if (value.is<std::string>())
+    {
+        const std::string name = value.as<std::string>();
+        for (const auto& [layerName, layer] : COLLISION_LAYER_NAMES)
+        {
+            if (name == layerName)
+            {
+                return layer;
+            }
+        }
+        Logger::Err("Unknown collision layer in level file: " + name);
+        return 0;
+    }
+
+    return defaultLayers;
+}
+
+// Adds the components described by a Lua components table to a prefab, replacing the ones it already has
+static void AddComponentsToPrefab(const sol::table& components, Prefab& prefab)
+{
+    // Transform
+    sol::optional<sol::table> transform = components["transform"];
+    if (transform != sol::nullopt)
+    {
+        prefab.AddComponent<TransformComponent>(
+            glm::vec2(
+                components["transform"]["position"]["x"],
+                components["transform"]["position"]["y"]
+            ),
+            glm::vec2(
+                components["transform"]["scale"]["x"].get_or(1.0),
+                components["transform"]["scale"]["y"].get_or(1.0)
+            ),
+            components["transform"]["rotation"].get_or(0.0)
+        );
+    }
+
+    // RigidBody
+    sol::optional<sol::table> rigidbody = components["rigidbody"];
+    if (rigidbody != sol::nullopt)
+    {
+        prefab.AddComponent<RigidbodyComponent>(
+            glm::vec2(
+                components["rigidbody"]["velocity"]["x"].get_or(0.0),
+                components["rigidbody"]["velocity"]["y"].get_or(0.0)
+            )
+        );
+    }
+
+    // Sprite
+    sol::optional<sol::table> sprite = components["sprite"];
+    if (sprite != sol::nullopt)
+    {
+        prefab.AddComponent<SpriteComponent>(
+            components["sprite"]["texture_asset_id"],
+            components["sprite"]["width"],
+            components["sprite"]["height"],
+            components["sprite"]["z_index"].get_or(1),
+            components["sprite"]["fixed"].get_or(false),
+            components["sprite"]["src_rect_x"].get_or(0),
+            components["sprite"]["src_rect_y"].get_or(0)
+        );
+    }
+
+    // Animation
+    sol::optional<sol::table> animation = components["animation"];
+    if (animation != sol::nullopt)
+    {
+        prefab.AddComponent<AnimationComponent>(
+            components["animation"]["num_frames"].get_or(1),
+            components["animation"]["speed_rate"].get_or(1)
+        );
+    }
+
+    // BoxCollider
+    sol::optional<sol::table> collider = components["boxcollider"];
+    if (collider != sol::nullopt)
+    {
+        prefab.AddComponent<BoxColliderComponent>(
+            components["boxcollider"]["width"],
+            components["boxcollider"]["height"],
+            glm::vec2(
+                components["boxcollider"]["offset"]["x"].get_or(0),
+                components["boxcollider"]["offset"]["y"].get_or(0)
+            ),
+            GetCollisionLayers(components["boxcollider"]["layer"], COLLISION_LAYER_DEFAULT),
+            GetCollisionLayers(components["boxcollider"]["mask"], COLLISION_LAYER_ALL)
+        );
+    }
+
+    // Health
+    sol::optional<sol::table> health = components["health"];
+    if (health != sol::nullopt)
+    {
+        prefab.AddComponent<HealthComponent>(
+            static_cast<int>(components["health"]["health_percentage"].get_or(100))
+        );
+    }
+
+    // ProjectileEmitter
+    sol::optional<sol::table> projectileEmitter = components["projectile_emitter"];
+    if (projectileEmitter != sol::nullopt)
+    {
+        prefab.AddComponent<ProjectileEmitterComponent>(
+            glm::vec2(
+                components["projectile_emitter"]["projectile_velocity"]["x"],
+                components["projectile_emitter"]["projectile_velocity"]["y"]
+            ),
+            static_cast<int>(components["projectile_emitter"]["repeat_frequency"].get_or(1)) * 1000,
+            static_cast<int>(components["projectile_emitter"]["projectile_duration"].get_or(10)) * 1000,
+            static_cast<int>(components["projectile_emitter"]["hit_percentage_damage"].get_or(10)),
+            components["projectile_emitter"]["friendly"].get_or(false)
+        );
+    }
+
+    // CameraFollow
+    sol::optional<sol::table> cameraFollow = components["camera_follow"];
+    if (cameraFollow != sol::nullopt)
+    {
+        prefab.AddComponent<CameraFollowComponent>();
+    }
+
+    // KeyboardControlled
+    sol::optional<sol::table> keyboardControlled = components["keyboard_controller"];
+    if (keyboardControlled != sol::nullopt)
+    {
+        prefab.AddComponent<KeyboardControlComponent>(
+            glm::vec2(
+                components["keyboard_controller"]["up_velocity"]["x"],
+                components["keyboard_controller"]["up_velocity"]["y"]
+            ),
+            glm::vec2(
+                components["keyboard_controller"]["right_velocity"]["x"],
+                components["keyboard_controller"]["right_velocity"]["y"]
+            ),
+            glm::vec2(
+                components["keyboard_controller"]["down_velocity"]["x"],
+                components["keyboard_controller"]["down_velocity"]["y"]
+            ),
+            glm::vec2(
+                components["keyboard_controller"]["left_velocity"]["x"],
+                components["keyboard_controller"]["left_velocity"]["y"]
+            )
+        );
+    }
+}
 
 LevelLoader::LevelLoader()
 {
@@ -91,6 +267,13 @@ void LevelLoader::LoadLevel(sol::state& lua, std::unique_ptr<Registry>& registry
     int tileSize = map["tile_size"];
     double mapScale = map["scale"];
 
+    // Every tile is created at once from the same prefab, then placed and given its source rectangle
+    Prefab tilePrefab;
+    tilePrefab
+        .AddComponent<TransformComponent>(glm::vec2(0.0, 0.0), glm::vec2(mapScale, mapScale), 0.0)
+        .AddComponent<SpriteComponent>(mapTextureAssetId, tileSize, tileSize, 0, false);
+    std::vector<Entity> tiles = registry->Instantiate(tilePrefab, mapNumRows * mapNumCols);
+
     std::fstream mapFile;
     mapFile.open(mapFilePath);
     for (int y = 0; y < mapNumRows; y++)
@@ -104,9 +287,11 @@ void LevelLoader::LoadLevel(sol::state& lua, std::unique_ptr<Registry>& registry
             int srcRectX = std::atoi(&ch) * tileSize;
             mapFile.ignore();
 
-            Entity tile = registry->CreateEntity();
-            tile.AddComponent<TransformComponent>(glm::vec2(x * (mapScale * tileSize), y * (mapScale * tileSize)), glm::vec2(mapScale, mapScale), 0.0);
-            tile.AddComponent<SpriteComponent>(mapTextureAssetId, tileSize, tileSize, 0, false, srcRectX, srcRectY);
+            Entity tile = tiles[y * mapNumCols + x];
+            tile.GetComponent<TransformComponent>().position = glm::vec2(x * (mapScale * tileSize), y * (mapScale * tileSize));
+            auto& sprite = tile.GetComponent<SpriteComponent>();
+            sprite.srcRect.x = srcRectX;
+            sprite.srcRect.y = srcRectY;
         }
     }
     mapFile.close();
@@ -114,162 +299,115 @@ void LevelLoader::LoadLevel(sol::state& lua, std::unique_ptr<Registry>& registry
     Game::mapWidth = mapNumCols * tileSize * mapScale;
     Game::mapHeight = mapNumRows * tileSize * mapScale;
 
-    sol::table entities = level["entities"];
-    i = 0;
-    while (true)
+    // Collision settings, the broadphase grid cell size should be about the size of the common colliders
+    sol::optional<sol::table> collision = level["collision"];
+    if (collision != sol::nullopt && registry->HasSystem<CollisionSystem>())
     {
-        sol::optional<sol::table> hasEntity = entities[i];
-        if (hasEntity == sol::nullopt)
+        auto& collisionSystem = registry->GetSystem<CollisionSystem>();
+
+        sol::optional<std::string> broadphase = collision.value()["broadphase"];
+        if (broadphase != sol::nullopt)
         {
-            break;
+            const BroadphaseType type = GetBroadphaseType(broadphase.value());
+            if (type == BROADPHASE_TYPE_COUNT)
+            {
+                Logger::Err("Unknown collision broadphase in level file: " + broadphase.value());
+            }
+            else
+            {
+                collisionSystem.SetBroadphaseType(type);
+            }
         }
 
-        sol::table entity = entities[i];
-
-        Entity newEntity = registry->CreateEntity();
-
-        // Tag
-        sol::optional<std::string> tag = entity["tag"];
-        if (tag != sol::nullopt)
+        sol::optional<double> cellSize = collision.value()["cell_size"];
+        if (cellSize != sol::nullopt)
         {
-            newEntity.Tag(entity["tag"]);
+            collisionSystem.SetCellSize(cellSize.value());
         }
 
-        // Group
-        sol::optional<std::string> group = entity["group"];
-        if (group != sol::nullopt)
+        sol::optional<double> fatMargin = collision.value()["fat_margin"];
+        if (fatMargin != sol::nullopt)
         {
-            newEntity.Group(entity["group"]);
+            collisionSystem.SetFatMargin(fatMargin.value());
         }
+    }
 
-        // Components
-        sol::optional<sol::table> hasComponents = entity["components"];
-        if (hasComponents != sol::nullopt)
+    // Prefabs, registered by name so entities of this level (or of later ones) can be based on them
+    sol::optional<sol::table> prefabs = level["prefabs"];
+    if (prefabs != sol::nullopt)
+    {
+        for (const auto& [name, definition] : prefabs.value())
         {
-            // Transform
-            sol::optional<sol::table> transform = entity["components"]["transform"];
-            if (transform != sol::nullopt)
-            {
-                newEntity.AddComponent<TransformComponent>(
-                    glm::vec2(
-                        entity["components"]["transform"]["position"]["x"],
-                        entity["components"]["transform"]["position"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["transform"]["scale"]["x"].get_or(1.0),
-                        entity["components"]["transform"]["scale"]["y"].get_or(1.0)
-                    ),
-                    entity["components"]["transform"]["rotation"].get_or(0.0)
-                );
-            }
+            sol::table prefabDefinition = definition;
+            Prefab prefab;
 
-            // RigidBody
-            sol::optional<sol::table> rigidbody = entity["components"]["rigidbody"];
-            if (rigidbody != sol::nullopt)
+            sol::optional<std::string> group = prefabDefinition["group"];
+            if (group != sol::nullopt)
             {
-                newEntity.AddComponent<RigidbodyComponent>(
-                    glm::vec2(
-                        entity["components"]["rigidbody"]["velocity"]["x"].get_or(0.0),
-                        entity["components"]["rigidbody"]["velocity"]["y"].get_or(0.0)
-                    )
-                );
+                prefab.Group(group.value());
             }
 
-            // Sprite
-            sol::optional<sol::table> sprite = entity["components"]["sprite"];
-            if (sprite != sol::nullopt)
+            sol::optional<sol::table> components = prefabDefinition["components"];
+            if (components != sol::nullopt)
             {
-                newEntity.AddComponent<SpriteComponent>(
-                    entity["components"]["sprite"]["texture_asset_id"],
-                    entity["components"]["sprite"]["width"],
-                    entity["components"]["sprite"]["height"],
-                    entity["components"]["sprite"]["z_index"].get_or(1),
-                    entity["components"]["sprite"]["fixed"].get_or(false),
-                    entity["components"]["sprite"]["src_rect_x"].get_or(0),
-                    entity["components"]["sprite"]["src_rect_y"].get_or(0)
-                );
+                AddComponentsToPrefab(components.value(), prefab);
             }
 
-            // Animation
-            sol::optional<sol::table> animation = entity["components"]["animation"];
-            if (animation != sol::nullopt)
-            {
-                newEntity.AddComponent<AnimationComponent>(
-                    entity["components"]["animation"]["num_frames"].get_or(1),
-                    entity["components"]["animation"]["speed_rate"].get_or(1)
-                );
-            }
+            registry->AddPrefab(name.as<std::string>(), std::move(prefab));
+            Logger::Log("Prefab added with name: " + name.as<std::string>());
+        }
+    }
 
-            // BoxCollider
-            sol::optional<sol::table> collider = entity["components"]["boxcollider"];
-            if (collider != sol::nullopt)
-            {
-                newEntity.AddComponent<BoxColliderComponent>(
-                    entity["components"]["boxcollider"]["width"],
-                    entity["components"]["boxcollider"]["height"],
-                    glm::vec2(
-                        entity["components"]["boxcollider"]["offset"]["x"].get_or(0),
-                        entity["components"]["boxcollider"]["offset"]["y"].get_or(0)
-                    )
-                );
-            }
+    sol::table entities = level["entities"];
+    i = 0;
+    while (true)
+    {
+        sol::optional<sol::table> hasEntity = entities[i];
+        if (hasEntity == sol::nullopt)
+        {
+            break;
+        }
 
-            // Health
-            sol::optional<sol::table> health = entity["components"]["health"];
-            if (health != sol::nullopt)
-            {
-                newEntity.AddComponent<HealthComponent>(
-                    static_cast<int>(entity["components"]["health"]["health_percentage"].get_or(100))
-                );
-            }
+        sol::table entity = entities[i];
 
-            // ProjectileEmitter
-            sol::optional<sol::table> projectileEmitter = entity["components"]["projectile_emitter"];
-            if (projectileEmitter != sol::nullopt)
+        // Prefab
+        Prefab prefab;
+        sol::optional<std::string> prefabName = entity["prefab"];
+        if (prefabName != sol::nullopt)
+        {
+            if (registry->HasPrefab(prefabName.value()))
             {
-                newEntity.AddComponent<ProjectileEmitterComponent>(
-                    glm::vec2(
-                        entity["components"]["projectile_emitter"]["projectile_velocity"]["x"],
-                        entity["components"]["projectile_emitter"]["projectile_velocity"]["y"]
-                    ),
-                    static_cast<int>(entity["components"]["projectile_emitter"]["repeat_frequency"].get_or(1)) * 1000,
-                    static_cast<int>(entity["components"]["projectile_emitter"]["projectile_duration"].get_or(10)) * 1000,
-                    static_cast<int>(entity["components"]["projectile_emitter"]["hit_percentage_damage"].get_or(10)),
-                    entity["components"]["projectile_emitter"]["friendly"].get_or(false)
-                );
+                prefab = registry->GetPrefab(prefabName.value());
             }
-
-            // CameraFollow
-            sol::optional<sol::table> cameraFollow = entity["components"]["camera_follow"];
-            if (cameraFollow != sol::nullopt)
+            else
             {
-                newEntity.AddComponent<CameraFollowComponent>();
+                Logger::Err("Entity " + std::to_string(i) + " uses the unknown prefab " + prefabName.value());
             }
+        }
 
-            // KeyboardControlled
-            sol::optional<sol::table> keyboardControlled = entity["components"]["keyboard_controller"];
-            if (keyboardControlled != sol::nullopt)
-            {
-                newEntity.AddComponent<KeyboardControlComponent>(
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["up_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["up_velocity"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["right_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["right_velocity"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["down_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["down_velocity"]["y"]
-                    ),
-                    glm::vec2(
-                        entity["components"]["keyboard_controller"]["left_velocity"]["x"],
-                        entity["components"]["keyboard_controller"]["left_velocity"]["y"]
-                    )
-                );
-            }
+        // Group
+        sol::optional<std::string> group = entity["group"];
+        if (group != sol::nullopt)
+        {
+            prefab.Group(group.value());
+        }
+
+        // Components, on top of the ones of the prefab the entity is based on
+        sol::optional<sol::table> hasComponents = entity["components"];
+        if (hasComponents != sol::nullopt)
+        {
+            AddComponentsToPrefab(hasComponents.value(), prefab);
+        }
+
+        Entity newEntity = registry->Instantiate(prefab);
+
+        // Tag
+        sol::optional<std::string> tag = entity["tag"];
+        if (tag != sol::nullopt)
+        {
+            newEntity.Tag(tag.value());
         }
+
         i++;
     }
 }
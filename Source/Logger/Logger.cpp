@@ -11,9 +11,13 @@
 #define DEFAULT_COLOR "\033[0m"
 
 std::vector<LogEntry> Logger::messages;
+std::mutex Logger::mutex;
 
 void Logger::Log(const std::string& message)
 {
+	// std::localtime and the message list are shared, so one thread logs at a time
+	std::lock_guard<std::mutex> lock(mutex);
+
 	LogEntry logEntry;
 	logEntry.type = LOG_INFO;
 	logEntry.message = "LOG: [" + GetCurrentDateTimeToString() + "]: " + message;
@@ -24,6 +28,8 @@ void Logger::Log(const std::string& message)
 
 void Logger::Err(const std::string& message)
 {
+	std::lock_guard<std::mutex> lock(mutex);
+
 	LogEntry logEntry;
 	logEntry.type = LOG_ERROR;
 	logEntry.message = "LOG: [" + GetCurrentDateTimeToString() + "]: " + message;
@@ -1,6 +1,7 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,9 @@ public:
 	static void Err(const std::string& message);
 
 private:
+	// Systems may log from worker threads
+	static std::mutex mutex;
+
 	static std::string GetCurrentDateTimeToString();
 };
 
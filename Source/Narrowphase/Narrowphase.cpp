@@ -0,0 +1,197 @@
+#include "Narrowphase.h"
+#include "../Logger/Logger.h"
+#include <cstring>
+
+// The SIMD kernels are built for x86-64, where SSE2 is always there, other CPUs get the scalar kernel
+#if defined(__x86_64__) || defined(_M_X64)
+#define NARROWPHASE_X64
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Lets a function use AVX while the rest of the build targets the baseline instruction set
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX __attribute__((target("avx")))
+#else
+#define TARGET_AVX
+#endif
+
+static const char* AABB_KERNEL_NAMES[AABB_KERNEL_COUNT] = { "scalar", "sse2", "avx" };
+
+const char* GetAABBKernelName(AABBKernel kernel)
+{
+    return kernel >= 0 && kernel < AABB_KERNEL_COUNT ? AABB_KERNEL_NAMES[kernel] : "unknown";
+}
+
+static bool IsAVXSupported()
+{
+#if !defined(NARROWPHASE_X64)
+    return false;
+#elif defined(_MSC_VER)
+    // The CPU must have AVX, and the OS must save the AVX registers on context switches
+    int info[4];
+    __cpuid(info, 1);
+    const bool hasAVX = (info[2] & (1 << 28)) != 0;
+    const bool hasOSXSAVE = (info[2] & (1 << 27)) != 0;
+    return hasAVX && hasOSXSAVE && (_xgetbv(0) & 6) == 6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+bool IsAABBKernelSupported(AABBKernel kernel)
+{
+    switch (kernel)
+    {
+        case AABB_KERNEL_SCALAR:
+            return true;
+        case AABB_KERNEL_SSE2:
+#if defined(NARROWPHASE_X64)
+            return true;
+#else
+            return false;
+#endif
+        case AABB_KERNEL_AVX:
+        {
+            static const bool isAVXSupported = IsAVXSupported();
+            return isAVXSupported;
+        }
+        default:
+            return false;
+    }
+}
+
+AABBKernel GetBestAABBKernel()
+{
+    for (int kernel = AABB_KERNEL_COUNT - 1; kernel > AABB_KERNEL_SCALAR; kernel--)
+    {
+        if (IsAABBKernelSupported(static_cast<AABBKernel>(kernel)))
+        {
+            return static_cast<AABBKernel>(kernel);
+        }
+    }
+    return AABB_KERNEL_SCALAR;
+}
+
+static void TestOverlapsScalar(const AABB& box, const float* minX, const float* minY, const float* maxX, const float* maxY, int count, uint8_t* overlaps)
+{
+    for (int i = 0; i < count; i++)
+    {
+        overlaps[i] = box.minX < maxX[i] && box.maxX > minX[i] && box.minY < maxY[i] && box.maxY > minY[i];
+    }
+}
+
+#if defined(NARROWPHASE_X64)
+// [Array index = 4 bit compare mask] [Value = the mask spread over 4 bytes, one per lane, lowest lane first]
+static const uint32_t MASK_BYTES[16] = {
+    0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+    0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101
+};
+
+// The ordered compares are false when a value is NaN, like the scalar compares
+static void TestOverlapsSSE2(const AABB& box, const float* minX, const float* minY, const float* maxX, const float* maxY, int count, uint8_t* overlaps)
+{
+    const __m128 boxMinX = _mm_set1_ps(box.minX);
+    const __m128 boxMinY = _mm_set1_ps(box.minY);
+    const __m128 boxMaxX = _mm_set1_ps(box.maxX);
+    const __m128 boxMaxY = _mm_set1_ps(box.maxY);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 overlapX = _mm_and_ps(_mm_cmplt_ps(boxMinX, _mm_loadu_ps(maxX + i)), _mm_cmpgt_ps(boxMaxX, _mm_loadu_ps(minX + i)));
+        const __m128 overlapY = _mm_and_ps(_mm_cmplt_ps(boxMinY, _mm_loadu_ps(maxY + i)), _mm_cmpgt_ps(boxMaxY, _mm_loadu_ps(minY + i)));
+        const int mask = _mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+        std::memcpy(overlaps + i, &MASK_BYTES[mask], 4);
+    }
+    TestOverlapsScalar(box, minX + i, minY + i, maxX + i, maxY + i, count - i, overlaps + i);
+}
+
+TARGET_AVX static void TestOverlapsAVX(const AABB& box, const float* minX, const float* minY, const float* maxX, const float* maxY, int count, uint8_t* overlaps)
+{
+    const __m256 boxMinX = _mm256_set1_ps(box.minX);
+    const __m256 boxMinY = _mm256_set1_ps(box.minY);
+    const __m256 boxMaxX = _mm256_set1_ps(box.maxX);
+    const __m256 boxMaxY = _mm256_set1_ps(box.maxY);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 overlapX = _mm256_and_ps(_mm256_cmp_ps(boxMinX, _mm256_loadu_ps(maxX + i), _CMP_LT_OQ), _mm256_cmp_ps(boxMaxX, _mm256_loadu_ps(minX + i), _CMP_GT_OQ));
+        const __m256 overlapY = _mm256_and_ps(_mm256_cmp_ps(boxMinY, _mm256_loadu_ps(maxY + i), _CMP_LT_OQ), _mm256_cmp_ps(boxMaxY, _mm256_loadu_ps(minY + i), _CMP_GT_OQ));
+        const int mask = _mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY));
+        std::memcpy(overlaps + i, &MASK_BYTES[mask & 15], 4);
+        std::memcpy(overlaps + i + 4, &MASK_BYTES[mask >> 4], 4);
+    }
+
+    // Upper halves of the AVX registers are cleared before returning to code that may use SSE
+    _mm256_zeroupper();
+    TestOverlapsScalar(box, minX + i, minY + i, maxX + i, maxY + i, count - i, overlaps + i);
+}
+#endif
+
+void TestAABBOverlaps(AABBKernel kernel, const AABB& box, const AABBArrays& candidates, int begin, int end, uint8_t* overlaps)
+{
+    const float* minX = candidates.minX.data() + begin;
+    const float* minY = candidates.minY.data() + begin;
+    const float* maxX = candidates.maxX.data() + begin;
+    const float* maxY = candidates.maxY.data() + begin;
+    const int count = end - begin;
+    overlaps += begin;
+
+    switch (kernel)
+    {
+#if defined(NARROWPHASE_X64)
+        case AABB_KERNEL_SSE2:
+            TestOverlapsSSE2(box, minX, minY, maxX, maxY, count, overlaps);
+            break;
+        case AABB_KERNEL_AVX:
+            TestOverlapsAVX(box, minX, minY, maxX, maxY, count, overlaps);
+            break;
+#endif
+        default:
+            TestOverlapsScalar(box, minX, minY, maxX, maxY, count, overlaps);
+            break;
+    }
+}
+
+void Narrowphase::SetKernel(AABBKernel kernel)
+{
+    if (!IsAABBKernelSupported(kernel))
+    {
+        Logger::Err(std::string("Narrowphase kernel ") + GetAABBKernelName(kernel) + " is not supported by this CPU");
+        return;
+    }
+    this->kernel = kernel;
+    Logger::Log(std::string("Narrowphase kernel set to ") + GetAABBKernelName(kernel));
+}
+
+AABBKernel Narrowphase::GetKernel() const
+{
+    return kernel;
+}
+
+void Narrowphase::TestPairs(std::span<const AABB> boxes, std::span<const BroadphasePair> pairs, std::vector<uint8_t>& overlaps)
+{
+    const int pairCount = static_cast<int>(pairs.size());
+    overlaps.resize(pairCount);
+    candidates.Resize(pairCount);
+    for (int i = 0; i < pairCount; i++)
+    {
+        candidates.Set(i, boxes[pairs[i].second]);
+    }
+
+    // One kernel call per run of pairs sharing their first box
+    for (int begin = 0, end = 0; begin < pairCount; begin = end)
+    {
+        const int first = pairs[begin].first;
+        end = begin + 1;
+        while (end < pairCount && pairs[end].first == first)
+        {
+            end++;
+        }
+        TestAABBOverlaps(kernel, boxes[first], candidates, begin, end, overlaps.data());
+    }
+}
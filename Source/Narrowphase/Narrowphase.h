@@ -0,0 +1,88 @@
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+#include "../Broadphase/Broadphase.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Narrowphase
+////////////////////////////////////////////////////////////////////////////////
+// Exact overlap test of the candidate pairs found by a broadphase. The boxes
+// of the candidates are gathered into one array per edge (a structure of
+// arrays), so a box can be tested against 4 (SSE2) or 8 (AVX) candidates with
+// one compare per edge. The kernel is picked at runtime from what the CPU
+// supports, and the scalar kernel is kept for other CPUs. All kernels give the
+// same results, so they can be switched at any time.
+////////////////////////////////////////////////////////////////////////////////
+enum AABBKernel
+{
+    AABB_KERNEL_SCALAR,
+    AABB_KERNEL_SSE2,
+    AABB_KERNEL_AVX,
+    AABB_KERNEL_COUNT
+};
+
+// Name of the kernel in debug output, e.g. "sse2"
+const char* GetAABBKernelName(AABBKernel kernel);
+
+bool IsAABBKernelSupported(AABBKernel kernel);
+
+// Widest kernel the CPU supports
+AABBKernel GetBestAABBKernel();
+
+// Boxes stored as one array per edge
+struct AABBArrays
+{
+    std::vector<float> minX;
+    std::vector<float> minY;
+    std::vector<float> maxX;
+    std::vector<float> maxY;
+
+    int GetSize() const
+    {
+        return static_cast<int>(minX.size());
+    }
+
+    void Resize(int size)
+    {
+        minX.resize(size);
+        minY.resize(size);
+        maxX.resize(size);
+        maxY.resize(size);
+    }
+
+    void Set(int index, const AABB& box)
+    {
+        minX[index] = box.minX;
+        minY[index] = box.minY;
+        maxX[index] = box.maxX;
+        maxY[index] = box.maxY;
+    }
+};
+
+// Sets overlaps[i] to 1 if box overlaps candidate i, for i in [begin, end), and to 0 otherwise. Edges are
+// excluded: touching boxes do not overlap. The kernel must be supported.
+void TestAABBOverlaps(AABBKernel kernel, const AABB& box, const AABBArrays& candidates, int begin, int end, uint8_t* overlaps);
+
+class Narrowphase
+{
+private:
+    AABBKernel kernel = GetBestAABBKernel();
+
+    // Second box of every pair, reused from frame to frame
+    AABBArrays candidates;
+
+public:
+    // Falls back to the current kernel if the CPU does not support the given one
+    void SetKernel(AABBKernel kernel);
+
+    AABBKernel GetKernel() const;
+
+    // Sets overlaps[i] to 1 if the boxes of pairs[i] overlap, edges excluded. The pairs sharing their first
+    // box are tested together, so pairs sorted by their first box are tested the fastest.
+    void TestPairs(std::span<const AABB> boxes, std::span<const BroadphasePair> pairs, std::vector<uint8_t>& overlaps);
+};
+
+#endif
@@ -13,6 +13,9 @@ class AnimationSystem : public System
         {
             RequireComponent<SpriteComponent>();
             RequireComponent<AnimationComponent>();
+
+            WritesComponent<SpriteComponent>();
+            WritesComponent<AnimationComponent>();
         }
 
         void Update() 
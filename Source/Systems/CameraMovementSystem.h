@@ -14,13 +14,17 @@ public:
     {
         RequireComponent<CameraFollowComponent>();
         RequireComponent<TransformComponent>();
+
+        // The camera itself is only touched by this system during the update
+        ReadsComponent<CameraFollowComponent>();
+        ReadsComponent<TransformComponent>();
     }
 
     void Update(SDL_Rect& camera)
     {
         for (auto entity : GetSystemEntities())
         {
-            const auto transform = entity.GetComponent<TransformComponent>();
+            const auto& transform = entity.ReadComponent<TransformComponent>();
 
             if (transform.position.x + (camera.w / 2) < Game::mapWidth)
             {
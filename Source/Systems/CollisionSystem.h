@@ -2,68 +2,189 @@
 #define COLLISIONSYSTEM_H
 
 #include "../ECS/ECS.h"
+#include "../Broadphase/DynamicAABBTree.h"
+#include "../Broadphase/SpatialHashGrid.h"
+#include "../Broadphase/SweepAndPrune.h"
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/TransformComponent.h"
 #include "../Events/CollisionEvent.h"
 #include "../Logger/Logger.h"
+#include "../Narrowphase/Narrowphase.h"
+#include <algorithm>
+#include <chrono>
 
 class CollisionSystem : public System
 {
+private:
+	// Reused every frame so gathering the colliders does not allocate in steady state
+	// [Vector index = box index]
+	std::vector<Entity> colliders;
+	std::vector<AABB> boxes;
+	std::vector<int> entityIds;
+	std::vector<CollisionFilter> filters;
+	std::vector<BroadphasePair> pairs;
+
+	// [Vector index = pair index]
+	std::vector<uint8_t> overlaps;
+	Narrowphase narrowphase;
+
+	// Broadphases the candidate pairs can come from, selected at runtime
+	BroadphaseType broadphaseType = BROADPHASE_SPATIAL_HASH;
+	BruteForceBroadphase bruteForce;
+	SpatialHashGrid grid;
+	SweepAndPrune sweepAndPrune;
+	DynamicAABBTree aabbTree;
+
+	// Whether the tree holds the colliders of the last Update(), it is only kept up to date every frame
+	// when it is the broadphase, otherwise the first region query of a frame syncs it
+	bool isAABBTreeCurrent = false;
+
+	// Stats of the last frame run with each broadphase, so they can be compared after switching
+	// [Array index = broadphase type]
+	BroadphaseStats stats[BROADPHASE_TYPE_COUNT];
+
+	IBroadphase& GetBroadphase()
+	{
+		switch (broadphaseType)
+		{
+			case BROADPHASE_BRUTE_FORCE:
+				return bruteForce;
+			case BROADPHASE_SWEEP_AND_PRUNE:
+				return sweepAndPrune;
+			case BROADPHASE_AABB_TREE:
+				return aabbTree;
+			default:
+				return grid;
+		}
+	}
+
 public:
 	CollisionSystem()
 	{
 		RequireComponent<TransformComponent>();
 		RequireComponent<BoxColliderComponent>();
+
+		// No component access is declared: the collision events run handlers of other systems,
+		// which may touch any component, so the scheduler runs this system on its own
+	}
+
+	// Side of the broadphase grid cells in pixels, set from the level file
+	void SetCellSize(float cellSize)
+	{
+		grid.SetCellSize(cellSize);
+		Logger::Log("Collision grid cell size set to " + std::to_string(grid.GetCellSize()));
 	}
 
-	void Update(std::unique_ptr<EventBus>& eventBus)
+	// Pixels the tree leaves are grown by around the colliders, set from the level file
+	void SetFatMargin(float fatMargin)
 	{
-		auto entities = GetSystemEntities();
+		aabbTree.SetFatMargin(fatMargin);
+		Logger::Log("Collision tree fat margin set to " + std::to_string(fatMargin));
+	}
 
-		for (auto i = entities.begin(); i != entities.end(); i++)
+	void SetBroadphaseType(BroadphaseType type)
+	{
+		if (type < 0 || type >= BROADPHASE_TYPE_COUNT)
 		{
-			Entity a = *i;
-			auto aTransform = a.GetComponent<TransformComponent>();
-			auto aCollider = a.GetComponent<BoxColliderComponent>();
+			Logger::Err("Unknown collision broadphase type " + std::to_string(type));
+			return;
+		}
+		broadphaseType = type;
+		Logger::Log(std::string("Collision broadphase set to ") + GetBroadphaseTypeName(type));
+	}
 
-			for (auto j = i; j != entities.end(); j++)
-			{
-				Entity b = *j;
-
-				if (a == b)
-				{
-					continue;
-				}
-
-				auto bTransform = b.GetComponent<TransformComponent>();
-				auto bCollider = b.GetComponent<BoxColliderComponent>();
-
-				bool collisionHappened = CheckAABBCollision(
-					aTransform.position.x + aCollider.offset.x,
-					aTransform.position.y + aCollider.offset.y,
-					aCollider.width,
-					aCollider.height,
-					bTransform.position.x + bCollider.offset.x,
-					bTransform.position.y + bCollider.offset.y,
-					bCollider.width,
-					bCollider.height
-				);
-
-				if (collisionHappened)
-				{
-					eventBus->EmitEvent<CollisionEvent>(a, b);
-					Logger::Log("Entity " + std::to_string(a.GetId()) + " is colliding with entity " + std::to_string(b.GetId()));
-				}
-			}
+	BroadphaseType GetBroadphaseType() const
+	{
+		return broadphaseType;
+	}
+
+	const BroadphaseStats& GetStats(BroadphaseType type) const
+	{
+		return stats[type];
+	}
+
+	void SetNarrowphaseKernel(AABBKernel kernel)
+	{
+		narrowphase.SetKernel(kernel);
+	}
+
+	AABBKernel GetNarrowphaseKernel() const
+	{
+		return narrowphase.GetKernel();
+	}
+
+	const DynamicAABBTree& GetAABBTree() const
+	{
+		return aabbTree;
+	}
+
+	// Calls func(entity) for every collider of the last Update() whose box overlaps the region, edges included
+	template<typename TFunc>
+	void QueryRegion(const AABB& region, TFunc&& func)
+	{
+		if (!isAABBTreeCurrent)
+		{
+			aabbTree.Update(boxes, entityIds);
+			isAABBTreeCurrent = true;
 		}
+
+		aabbTree.Query(region, [&](int boxIndex, int)
+		{
+			func(colliders[boxIndex]);
+		});
 	}
 
-	bool CheckAABBCollision(double aX, double aY, double aW, double aH, double bX, double bY, double bW, double bH)
+	void Update(std::unique_ptr<Registry>& registry, std::unique_ptr<EventBus>& eventBus)
 	{
-		return (aX < bX + bW &&
-				aX + aW > bX &&
-				aY < bY + bH &&
-				aY + aH > bY); 
+		colliders.clear();
+		boxes.clear();
+		entityIds.clear();
+		filters.clear();
+		pairs.clear();
+
+		registry->View<const TransformComponent, const BoxColliderComponent>().Each([&](Entity entity, const TransformComponent& transform, const BoxColliderComponent& collider)
+		{
+			colliders.push_back(entity);
+
+			const float x = transform.position.x + collider.offset.x;
+			const float y = transform.position.y + collider.offset.y;
+			boxes.push_back({ x, y, x + collider.width, y + collider.height });
+			entityIds.push_back(entity.GetId());
+			filters.push_back({ collider.layer, collider.mask });
+		});
+
+		const auto broadphaseStart = std::chrono::steady_clock::now();
+		GetBroadphase().FindPairs(boxes, entityIds, filters, pairs);
+		isAABBTreeCurrent = broadphaseType == BROADPHASE_AABB_TREE;
+
+		// Events go out in the order the full pairwise loop used to emit them, whatever the broadphase
+		std::sort(pairs.begin(), pairs.end());
+		const auto broadphaseEnd = std::chrono::steady_clock::now();
+
+		narrowphase.TestPairs(boxes, pairs, overlaps);
+
+		int collisionCount = 0;
+
+		for (int pairIndex = 0; pairIndex < static_cast<int>(pairs.size()); pairIndex++)
+		{
+			if (overlaps[pairIndex])
+			{
+				Entity a = colliders[pairs[pairIndex].first];
+				Entity b = colliders[pairs[pairIndex].second];
+				collisionCount++;
+				eventBus->EmitEvent<CollisionEvent>(a, b);
+				Logger::Log("Entity " + std::to_string(a.GetId()) + " is colliding with entity " + std::to_string(b.GetId()));
+			}
+		}
+
+		// The narrowphase time includes the collision handlers run by the events
+		BroadphaseStats& frameStats = stats[broadphaseType];
+		frameStats.colliderCount = static_cast<int>(colliders.size());
+		frameStats.candidatePairCount = static_cast<int>(pairs.size());
+		frameStats.collisionCount = collisionCount;
+		frameStats.broadphaseMilliseconds = std::chrono::duration<double, std::milli>(broadphaseEnd - broadphaseStart).count();
+		frameStats.narrowphaseMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - broadphaseEnd).count();
+		frameStats.averageBroadphaseMilliseconds += (frameStats.broadphaseMilliseconds - frameStats.averageBroadphaseMilliseconds) * 0.1;
 	}
 };
 
@@ -19,22 +19,26 @@ private:
 
         Logger::Log("Collision between " + std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()) + "!");
 
-        if (a.BelongsToGroup("projectiles") && b.HasTag("player"))
+        const int projectiles = a.registry->FindGroupId("projectiles");
+        const int enemies = a.registry->FindGroupId("enemies");
+        const int player = a.registry->FindTagId("player");
+
+        if (a.BelongsToGroup(projectiles) && b.HasTag(player))
         {
             OnProjectileHitsPlayer(a, b);
         }
 
-        if (b.BelongsToGroup("projectiles") && a.HasTag("player"))
+        if (b.BelongsToGroup(projectiles) && a.HasTag(player))
         {
             OnProjectileHitsPlayer(b, a);
         }
 
-        if (a.BelongsToGroup("projectiles") && b.BelongsToGroup("enemies"))
+        if (a.BelongsToGroup(projectiles) && b.BelongsToGroup(enemies))
         {
             OnProjectileHitsEnemy(a, b);
         }
 
-        if (b.BelongsToGroup("projectiles") && a.BelongsToGroup("enemies"))
+        if (b.BelongsToGroup(projectiles) && a.BelongsToGroup(enemies))
         {
             OnProjectileHitsEnemy(b, a);
         }
@@ -42,7 +46,7 @@ private:
 
     void OnProjectileHitsPlayer(Entity projectile, Entity player)
     {
-        auto projectileComponent = projectile.GetComponent<ProjectileComponent>();
+        const auto& projectileComponent = projectile.ReadComponent<ProjectileComponent>();
 
         if (!projectileComponent.isFriendly)
         {
@@ -60,7 +64,7 @@ private:
 
     void OnProjectileHitsEnemy(Entity projectile, Entity enemy)
     {
-        auto projectileComponent = projectile.GetComponent<ProjectileComponent>();
+        const auto& projectileComponent = projectile.ReadComponent<ProjectileComponent>();
 
         if (projectileComponent.isFriendly)
         {
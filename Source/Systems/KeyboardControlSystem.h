@@ -18,7 +18,7 @@ private:
     {
         for (auto entity : GetSystemEntities())
         {
-            const auto keyboardControl = entity.GetComponent<KeyboardControlComponent>();
+            const auto& keyboardControl = entity.ReadComponent<KeyboardControlComponent>();
             auto& sprite = entity.GetComponent<SpriteComponent>();
             auto& rigidbody = entity.GetComponent<RigidbodyComponent>();
 
@@ -15,6 +15,9 @@
 class MovementSystem : public System
 {
 private:
+	// Entities integrated per parallel work item
+	static constexpr int chunkSize = 1024;
+
 	void OnCollision(CollisionEvent& event)
 	{
 		Entity a = event.a;
@@ -22,12 +25,15 @@ private:
 
 		Logger::Log("Collision between " + std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()) + "!");
 
-		if (a.BelongsToGroup("enemies") && b.BelongsToGroup("obstacles"))
+		const int enemies = a.registry->FindGroupId("enemies");
+		const int obstacles = a.registry->FindGroupId("obstacles");
+
+		if (a.BelongsToGroup(enemies) && b.BelongsToGroup(obstacles))
 		{
 			OnEnemyHitsObstacle(a, b);
 		}
 
-		if (a.BelongsToGroup("obstacles") && b.BelongsToGroup("enemies"))
+		if (a.BelongsToGroup(obstacles) && b.BelongsToGroup(enemies))
 		{
 			OnEnemyHitsObstacle(b, a);
 		}
@@ -59,19 +65,28 @@ public:
 	{
 		RequireComponent<TransformComponent>();
 		RequireComponent<RigidbodyComponent>();
+
+		WritesComponent<TransformComponent>();
+		ReadsComponent<RigidbodyComponent>();
 	}
 
-	void Update(float deltaTime)
+	// Called once at setup, Update() only looks the group up
+	void DeclareComponentGroups(std::unique_ptr<Registry>& registry)
 	{
-		for (auto entity : GetSystemEntities())
-		{
-			auto& transform = entity.GetComponent<TransformComponent>();
-			const auto rigidbody = entity.GetComponent<RigidbodyComponent>();
+		registry->DeclareGroup<const RigidbodyComponent>(Observed<TransformComponent>());
+	}
 
+	void Update(std::unique_ptr<Registry>& registry, float deltaTime)
+	{
+		const int playerTag = registry->FindTagId("player");
+
+		// Rigidbodies are packed at the front of their pool, transforms are owned by the render group
+		registry->Group<const RigidbodyComponent>(Observed<TransformComponent>()).ParallelForEach(chunkSize, [&](Entity entity, const RigidbodyComponent& rigidbody, TransformComponent& transform)
+		{
 			transform.position.x += rigidbody.velocity.x * deltaTime;
 			transform.position.y += rigidbody.velocity.y * deltaTime;
 
-			if (entity.HasTag("player"))
+			if (entity.HasTag(playerTag))
 			{
 				const int paddingLeft = 10;
 				const int paddingTop = 10;
@@ -89,11 +104,11 @@ public:
 										|| transform.position.y < 0
 										|| transform.position.y > Game::mapHeight;
 
-			if (isEntityOutsideMap && !entity.HasTag("player"))
+			if (isEntityOutsideMap && !entity.HasTag(playerTag))
 			{
 				entity.Kill();
 			}
-		}
+		});
 	}
 
 	void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus)
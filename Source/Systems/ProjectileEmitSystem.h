@@ -14,6 +14,22 @@
 class ProjectileEmitSystem : public System
 {
 private:
+    // Projectiles are recorded here and spawned in bulk by the next registry Update()
+    CommandBuffer commandBuffer;
+
+    // The parts of a projectile that do not depend on the emitter. The other components are only added per
+    // projectile, so each of them is constructed once instead of being copied from the prefab and replaced.
+    std::shared_ptr<const Prefab> projectilePrefab;
+
+    void EmitProjectile(glm::vec2 position, glm::vec2 velocity, const ProjectileEmitterComponent& projectileEmitter)
+    {
+        Entity projectile = commandBuffer.Instantiate(projectilePrefab);
+        commandBuffer.AddComponent<TransformComponent>(projectile, position, glm::vec2(1.0f, 1.0f), 0);
+        commandBuffer.AddComponent<RigidbodyComponent>(projectile, velocity);
+        commandBuffer.AddComponent<BoxColliderComponent>(projectile, 4, 4, glm::vec2(0.0f, 0.0f), COLLISION_LAYER_PROJECTILES, projectileEmitter.isFriendly ? COLLISION_LAYER_ENEMIES : COLLISION_LAYER_PLAYER);
+        commandBuffer.AddComponent<ProjectileComponent>(projectile, projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
+    }
+
     void OnKeyPressed(KeyPressedEvent& event)
     {
         if (event.keyCode == SDLK_SPACE)
@@ -22,14 +38,14 @@ private:
             {
                 if (entity.HasComponent<CameraFollowComponent>())
                 {
-                    const auto projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
-                    const auto transform = entity.GetComponent<TransformComponent>();
-                    const auto rigidbody = entity.GetComponent<RigidbodyComponent>();
+                    const auto& projectileEmitter = entity.ReadComponent<ProjectileEmitterComponent>();
+                    const auto& transform = entity.ReadComponent<TransformComponent>();
+                    const auto& rigidbody = entity.ReadComponent<RigidbodyComponent>();
 
                     glm::vec2 projectilePosition = transform.position;
                     if (entity.HasComponent<SpriteComponent>())
                     {
-                        auto sprite = entity.GetComponent<SpriteComponent>();
+                        const auto& sprite = entity.ReadComponent<SpriteComponent>();
                         projectilePosition.x += (transform.scale.x * sprite.width / 2);
                         projectilePosition.y += (transform.scale.y * sprite.height / 2);
                     }
@@ -44,13 +60,11 @@ private:
                     projectileVelocity.x = projectileEmitter.projectileVelocity.x * directionX;
                     projectileVelocity.y = projectileEmitter.projectileVelocity.y * directionY;
 
-                    Entity projectile = entity.registry->CreateEntity();
-                    projectile.Group("projectiles");
-                    projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0f, 1.0f), 0);
-                    projectile.AddComponent<RigidbodyComponent>(projectileVelocity);
-                    projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-                    projectile.AddComponent<BoxColliderComponent>(4, 4, glm::vec2(0.0f, 0.0f));
-                    projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
+                    EmitProjectile(projectilePosition, projectileVelocity, projectileEmitter);
+
+                    // Input is handled before the registry Update() of the frame, submitting now spawns the
+                    // projectile this frame instead of with the next batch of the emitters
+                    entity.registry->SubmitCommandBuffer(commandBuffer);
                 }
             }
         }
@@ -61,6 +75,16 @@ public:
     {
         RequireComponent<ProjectileEmitterComponent>();
         RequireComponent<TransformComponent>();
+
+        WritesComponent<ProjectileEmitterComponent>();
+        ReadsComponent<TransformComponent>();
+        ReadsComponent<SpriteComponent>();
+
+        Prefab prefab;
+        prefab
+            .AddComponent<SpriteComponent>("bullet-image", 4, 4, 4)
+            .Group("projectiles");
+        projectilePrefab = std::make_shared<const Prefab>(std::move(prefab));
     }
 
     void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus)
@@ -73,7 +97,7 @@ public:
         for (auto entity : GetSystemEntities())
         {
             auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
-            const auto transform = entity.GetComponent<TransformComponent>();
+            const auto& transform = entity.ReadComponent<TransformComponent>();
 
             if (projectileEmitter.repeatFrequency == 0)
             {
@@ -86,22 +110,18 @@ public:
 
                 if (entity.HasComponent<SpriteComponent>())
                 {
-                    const auto sprite = entity.GetComponent<SpriteComponent>();
+                    const auto& sprite = entity.ReadComponent<SpriteComponent>();
                     projectilePosition.x += (transform.scale.x * sprite.width / 2);
                     projectilePosition.y += (transform.scale.y * sprite.height / 2);
                 }
 
-                Entity projectile = registry->CreateEntity();
-                projectile.Group("projectiles");
-                projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0f, 1.0f), 0);
-                projectile.AddComponent<RigidbodyComponent>(projectileEmitter.projectileVelocity);
-                projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-                projectile.AddComponent<BoxColliderComponent>(4, 4, glm::vec2(0.0f, 0.0f));
-                projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
+                EmitProjectile(projectilePosition, projectileEmitter.projectileVelocity, projectileEmitter);
 
                 projectileEmitter.lastEmissionTime = SDL_GetTicks();
             }
         }
+
+        registry->SubmitCommandBuffer(commandBuffer);
     }
 };
 
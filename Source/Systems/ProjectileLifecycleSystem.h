@@ -11,13 +11,15 @@ public:
     ProjectileLifecycleSystem()
     {
         RequireComponent<ProjectileComponent>();
+
+        ReadsComponent<ProjectileComponent>();
     };
 
     void Update()
     {
         for (auto entity : GetSystemEntities())
         {
-            const auto projectile = entity.GetComponent<ProjectileComponent>();
+            const auto& projectile = entity.ReadComponent<ProjectileComponent>();
 
             if (SDL_GetTicks() - projectile.startTime > projectile.duration)
             {
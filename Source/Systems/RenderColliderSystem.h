@@ -5,6 +5,7 @@
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/BoxColliderComponent.h"
+#include "CollisionSystem.h"
 
 class RenderColliderSystem : public System
 {
@@ -15,12 +16,12 @@ public:
 		RequireComponent<BoxColliderComponent>();
 	}
 
-	void Update(SDL_Renderer* renderer, SDL_Rect& camera)
+	void Update(std::unique_ptr<Registry>& registry, SDL_Renderer* renderer, SDL_Rect& camera)
 	{
-		for (auto entity : GetSystemEntities())
+		auto drawCollider = [&](Entity entity)
 		{
-			const auto transform = entity.GetComponent<TransformComponent>();
-			const auto collider = entity.GetComponent<BoxColliderComponent>();
+			const auto& transform = entity.ReadComponent<TransformComponent>();
+			const auto& collider = entity.ReadComponent<BoxColliderComponent>();
 
 			SDL_Rect colliderRect = {
 				static_cast<int>(transform.position.x + collider.offset.x - camera.x),
@@ -30,6 +31,24 @@ public:
 			};
 			SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
 			SDL_RenderDrawRect(renderer, &colliderRect);
+		};
+
+		// Only the colliders in view are drawn, found through the collision tree instead of a pass over all of them
+		if (registry->HasSystem<CollisionSystem>())
+		{
+			const AABB view = {
+				static_cast<float>(camera.x),
+				static_cast<float>(camera.y),
+				static_cast<float>(camera.x + camera.w),
+				static_cast<float>(camera.y + camera.h)
+			};
+			registry->GetSystem<CollisionSystem>().QueryRegion(view, drawCollider);
+			return;
+		}
+
+		for (auto entity : GetSystemEntities())
+		{
+			drawCollider(entity);
 		}
 	}
 };
@@ -12,6 +12,7 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/ProjectileEmitterComponent.h"
 #include "../Components/HealthComponent.h"
+#include "CollisionSystem.h"
 
 class RenderGUISystem : public System
 {
@@ -82,16 +83,18 @@ public:
 
             if (ImGui::Button("Spawn new enemy"))
             {
-                Entity enemy = registry->CreateEntity();
-                enemy.Group("enemies");
-                enemy.AddComponent<TransformComponent>(glm::vec2(posX, posY), glm::vec2(scaleX, scaleY), glm::degrees(rotation));
-                enemy.AddComponent<RigidbodyComponent>(glm::vec2(velX, velY));
-                enemy.AddComponent<SpriteComponent>(sprites[selectedSpriteIndex], 32, 32, 2);
-                enemy.AddComponent<BoxColliderComponent>(25, 20, glm::vec2(5, 5));
+                CommandBuffer commandBuffer;
+                Entity enemy = commandBuffer.CreateEntity();
+                commandBuffer.GroupEntity(enemy, "enemies");
+                commandBuffer.AddComponent<TransformComponent>(enemy, glm::vec2(posX, posY), glm::vec2(scaleX, scaleY), glm::degrees(rotation));
+                commandBuffer.AddComponent<RigidbodyComponent>(enemy, glm::vec2(velX, velY));
+                commandBuffer.AddComponent<SpriteComponent>(enemy, sprites[selectedSpriteIndex], 32, 32, 2);
+                commandBuffer.AddComponent<BoxColliderComponent>(enemy, 25, 20, glm::vec2(5, 5), COLLISION_LAYER_ENEMIES, COLLISION_LAYER_PROJECTILES | COLLISION_LAYER_OBSTACLES);
                 double projVelX = cos(projAngle) * projSpeed;
                 double projVelY = sin(projAngle) * projSpeed;
-                enemy.AddComponent<ProjectileEmitterComponent>(glm::vec2(projVelX, projVelY), projRepeat * 1000, projDuration * 1000, 10, false);
-                enemy.AddComponent<HealthComponent>(health);
+                commandBuffer.AddComponent<ProjectileEmitterComponent>(enemy, glm::vec2(projVelX, projVelY), projRepeat * 1000, projDuration * 1000, 10, false);
+                commandBuffer.AddComponent<HealthComponent>(enemy, health);
+                registry->SubmitCommandBuffer(commandBuffer);
 
                 posX = posY = rotation = projAngle = 0;
                 scaleX = scaleY = 1;
@@ -102,6 +105,109 @@ public:
         }
         ImGui::End();
 
+        if (ImGui::Begin("ECS memory"))
+        {
+            const MemoryStats stats = registry->GetMemoryStats();
+            ImGui::Text("Total: %.1f KB (%.1f KB wasted)", stats.GetTotalBytes() / 1024.0, stats.GetWastedBytes() / 1024.0);
+            ImGui::Text("Entity ids: %d (%d free)", stats.entityIdCount, stats.freeEntityIdCount);
+            ImGui::Text("Entity bookkeeping: %.1f KB (%.1f KB wasted)", stats.entityBytes / 1024.0, stats.entityWastedBytes / 1024.0);
+            ImGui::Text("Tags: %d, groups: %d, %.1f KB", stats.tagCount, stats.groupCount, stats.tagAndGroupBytes / 1024.0);
+            if (ImGui::Button("Shrink to fit"))
+            {
+                registry->ShrinkToFit();
+            }
+            ImGui::Separator();
+
+            ImGui::Columns(5, "component storages");
+            for (const char* header : {"component", "size", "capacity", "KB", "wasted KB"})
+            {
+                ImGui::Text("%s", header);
+                ImGui::NextColumn();
+            }
+            ImGui::Separator();
+            for (const auto& storage : stats.componentStorages)
+            {
+                ImGui::Text("%s", storage.name.c_str());
+                ImGui::NextColumn();
+                ImGui::Text("%d", storage.size);
+                ImGui::NextColumn();
+                ImGui::Text("%d", storage.capacity);
+                ImGui::NextColumn();
+                ImGui::Text("%.1f", storage.bytes / 1024.0);
+                ImGui::NextColumn();
+                ImGui::Text("%.1f", storage.wastedBytes / 1024.0);
+                ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+        }
+        ImGui::End();
+
+        if (registry->HasSystem<CollisionSystem>())
+        {
+            auto& collisionSystem = registry->GetSystem<CollisionSystem>();
+            if (ImGui::Begin("Collision broadphase"))
+            {
+                int selectedType = collisionSystem.GetBroadphaseType();
+                for (int type = 0; type < BROADPHASE_TYPE_COUNT; type++)
+                {
+                    if (ImGui::RadioButton(GetBroadphaseTypeName(static_cast<BroadphaseType>(type)), &selectedType, type))
+                    {
+                        collisionSystem.SetBroadphaseType(static_cast<BroadphaseType>(selectedType));
+                    }
+                }
+                ImGui::Separator();
+
+                // Only the kernels this CPU can run are offered
+                int selectedKernel = collisionSystem.GetNarrowphaseKernel();
+                ImGui::Text("narrowphase kernel");
+                for (int kernel = 0; kernel < AABB_KERNEL_COUNT; kernel++)
+                {
+                    if (IsAABBKernelSupported(static_cast<AABBKernel>(kernel)))
+                    {
+                        ImGui::SameLine();
+                        if (ImGui::RadioButton(GetAABBKernelName(static_cast<AABBKernel>(kernel)), &selectedKernel, kernel))
+                        {
+                            collisionSystem.SetNarrowphaseKernel(static_cast<AABBKernel>(selectedKernel));
+                        }
+                    }
+                }
+                ImGui::Separator();
+
+                // Every row keeps the last frame run with that broadphase
+                ImGui::Columns(6, "broadphase stats");
+                for (const char* header : {"broadphase", "colliders", "pairs", "collisions", "broad ms (avg)", "narrow ms"})
+                {
+                    ImGui::Text("%s", header);
+                    ImGui::NextColumn();
+                }
+                ImGui::Separator();
+                for (int type = 0; type < BROADPHASE_TYPE_COUNT; type++)
+                {
+                    const BroadphaseStats& stats = collisionSystem.GetStats(static_cast<BroadphaseType>(type));
+                    ImGui::Text("%s", GetBroadphaseTypeName(static_cast<BroadphaseType>(type)));
+                    ImGui::NextColumn();
+                    ImGui::Text("%d", stats.colliderCount);
+                    ImGui::NextColumn();
+                    ImGui::Text("%d", stats.candidatePairCount);
+                    ImGui::NextColumn();
+                    ImGui::Text("%d", stats.collisionCount);
+                    ImGui::NextColumn();
+                    ImGui::Text("%.3f (%.3f)", stats.broadphaseMilliseconds, stats.averageBroadphaseMilliseconds);
+                    ImGui::NextColumn();
+                    ImGui::Text("%.3f", stats.narrowphaseMilliseconds);
+                    ImGui::NextColumn();
+                }
+                ImGui::Columns(1);
+                ImGui::Separator();
+
+                // Only kept up to date while the tree is the broadphase or answers region queries
+                const AABBTreeStats treeStats = collisionSystem.GetAABBTree().GetStats();
+                ImGui::Text("aabb_tree: %d nodes, %d leaves, height %d", treeStats.nodeCount, treeStats.leafCount, treeStats.height);
+                ImGui::Text("last update: %d refits, %d rotations", treeStats.refitCount, treeStats.rotationCount);
+            }
+            ImGui::End();
+        }
+
         ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
                                        ImGuiWindowFlags_NoNav;
         ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always, ImVec2(0, 0));
@@ -22,9 +22,9 @@ public:
     {
         for (auto entity : GetSystemEntities())
         {
-            const auto transform = entity.GetComponent<TransformComponent>();
-            const auto sprite = entity.GetComponent<SpriteComponent>();
-            const auto health = entity.GetComponent<HealthComponent>();
+            const auto& transform = entity.ReadComponent<TransformComponent>();
+            const auto& sprite = entity.ReadComponent<SpriteComponent>();
+            const auto& health = entity.ReadComponent<HealthComponent>();
 
             SDL_Color healthBarColor = {255, 255, 255};
 
@@ -10,6 +10,22 @@
 
 class RenderSystem : public System 
 {
+private:
+    struct RenderableEntity 
+    {
+        int entityId;
+        const TransformComponent* transformComponent;
+        const SpriteComponent* spriteComponent;
+    };
+
+    // Sprites processed per parallel culling work item
+    static constexpr int chunkSize = 1024;
+
+    // Visible sprites found by each thread, then merged and sorted. Both are reused every frame
+    // so culling and sorting do not allocate in steady state.
+    std::unique_ptr<ThreadLocalBuffers<std::vector<RenderableEntity>>> visibleEntitiesPerThread;
+    std::vector<RenderableEntity> renderableEntities;
+
 public:
     RenderSystem() 
     {
@@ -17,44 +33,55 @@ public:
         RequireComponent<SpriteComponent>();
     }
 
-    void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, SDL_Rect& camera)
+    // Called once at setup, Update() only looks the group up
+    void DeclareComponentGroups(std::unique_ptr<Registry>& registry)
     {
-        struct RenderableEntity 
-        {
-            TransformComponent transformComponent;
-            SpriteComponent spriteComponent;
-        };
-
-        std::vector<RenderableEntity> renderableEntities;
+        registry->DeclareGroup<const TransformComponent, const SpriteComponent>();
+    }
 
-        for (auto entity : GetSystemEntities()) 
+    void Update(std::unique_ptr<Registry>& registry, SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, SDL_Rect& camera)
+    {
+        if (!visibleEntitiesPerThread)
         {
-            RenderableEntity renderableEntity;
-            renderableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
-            renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
+            visibleEntitiesPerThread = std::make_unique<ThreadLocalBuffers<std::vector<RenderableEntity>>>(registry->GetThreadPool());
+        }
 
+        registry->Group<const TransformComponent, const SpriteComponent>().ParallelForEach(chunkSize, [&](Entity entity, const TransformComponent& transform, const SpriteComponent& sprite)
+        {
             bool isEntityOutsideCameraView =
-                    renderableEntity.transformComponent.position.x + (renderableEntity.transformComponent.scale.x * renderableEntity.spriteComponent.width) < camera.x ||
-                    renderableEntity.transformComponent.position.x > camera.x + camera.w ||
-                    renderableEntity.transformComponent.position.y + (renderableEntity.transformComponent.scale.y * renderableEntity.spriteComponent.height) < camera.y ||
-                    renderableEntity.transformComponent.position.y > camera.y + camera.h;
+                    transform.position.x + (transform.scale.x * sprite.width) < camera.x ||
+                    transform.position.x > camera.x + camera.w ||
+                    transform.position.y + (transform.scale.y * sprite.height) < camera.y ||
+                    transform.position.y > camera.y + camera.h;
 
-            if (isEntityOutsideCameraView && !renderableEntity.spriteComponent.isFixed)
+            if (isEntityOutsideCameraView && !sprite.isFixed)
             {
-                continue;
+                return;
             }
 
-            renderableEntities.emplace_back(renderableEntity);
-        }
+            visibleEntitiesPerThread->Local().push_back({ entity.GetId(), &transform, &sprite });
+        });
 
+        renderableEntities.clear();
+        visibleEntitiesPerThread->ForEach([&](std::vector<RenderableEntity>& visibleEntities)
+        {
+            renderableEntities.insert(renderableEntities.end(), visibleEntities.begin(), visibleEntities.end());
+            visibleEntities.clear();
+        });
+
+        // The entity id breaks zIndex ties, so the draw order does not depend on how the culling was split
         std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b) {
-            return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
+            if (a.spriteComponent->zIndex != b.spriteComponent->zIndex)
+            {
+                return a.spriteComponent->zIndex < b.spriteComponent->zIndex;
+            }
+            return a.entityId < b.entityId;
             });
 
-        for (auto entity : renderableEntities) 
+        for (const auto& entity : renderableEntities) 
         {
-            const auto transform = entity.transformComponent;
-            const auto sprite = entity.spriteComponent;
+            const auto& transform = *entity.transformComponent;
+            const auto& sprite = *entity.spriteComponent;
 
             SDL_Rect srcRect = sprite.srcRect;
 
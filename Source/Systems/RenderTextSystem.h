@@ -18,7 +18,7 @@ public:
     {
         for (auto entity : GetSystemEntities())
         {
-            const auto textLabel = entity.GetComponent<TextLabelComponent>();
+            const auto& textLabel = entity.ReadComponent<TextLabelComponent>();
 
             SDL_Surface* surface = TTF_RenderText_Blended(assetStore->GetFont(textLabel.assetId), textLabel.text.c_str(), textLabel.color);
             SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+
+// The pool and worker index of the current thread, so tasks submitted from a worker go to its own queue
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local unsigned int currentWorkerIndex = 0;
+
+ThreadPool::ThreadPool(unsigned int workerCount) : queuedTasks(0), isStopping(false)
+{
+    for (unsigned int i = 0; i <= workerCount; i++)
+    {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+
+    workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isStopping = true;
+    }
+    wakeUp.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+unsigned int ThreadPool::GetWorkerCount() const
+{
+    return static_cast<unsigned int>(workers.size());
+}
+
+unsigned int ThreadPool::GetCurrentThreadIndex() const
+{
+    return currentPool == this ? currentWorkerIndex : static_cast<unsigned int>(workers.size());
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    TaskQueue& queue = *queues[GetCurrentThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    queuedTasks++;
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::TryRunTask(unsigned int queueIndex)
+{
+    std::function<void()> task;
+
+    // Newest task of our own queue first, it is the most likely to still be in cache
+    {
+        TaskQueue& queue = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+
+    // Otherwise steal the oldest task of another queue
+    for (size_t i = 1; !task && i < queues.size(); i++)
+    {
+        TaskQueue& queue = *queues[(queueIndex + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+
+    queuedTasks--;
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(unsigned int workerIndex)
+{
+    currentPool = this;
+    currentWorkerIndex = workerIndex;
+
+    while (true)
+    {
+        if (TryRunTask(workerIndex))
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return isStopping || queuedTasks > 0; });
+        if (isStopping)
+        {
+            return;
+        }
+    }
+}
+
+void ThreadPool::Wait(const std::atomic<int>& pendingTasks)
+{
+    const unsigned int queueIndex = GetCurrentThreadIndex();
+    while (pendingTasks > 0)
+    {
+        if (!TryRunTask(queueIndex))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// ThreadPool
+////////////////////////////////////////////////////////////////////////////////
+// A fixed set of worker threads with one task queue each. Workers take tasks
+// from the back of their own queue and steal from the front of the others when
+// they run dry. Threads that are not workers share one extra queue, and help
+// running tasks while they Wait() instead of blocking.
+////////////////////////////////////////////////////////////////////////////////
+class ThreadPool
+{
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // [Vector index = worker index], the last queue is shared by the non-worker threads
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<int> queuedTasks;
+    bool isStopping;
+
+    // Idle workers sleep here until a task is submitted
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    // Runs one task, preferring the given queue and stealing from the others. Returns false if all queues were empty.
+    bool TryRunTask(unsigned int queueIndex);
+
+    void WorkerLoop(unsigned int workerIndex);
+
+public:
+    // By default one worker per hardware thread, minus the thread that submits the work
+    explicit ThreadPool(unsigned int workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int GetWorkerCount() const;
+
+    // Worker index of the calling thread, or GetWorkerCount() for any thread that is not a worker
+    unsigned int GetCurrentThreadIndex() const;
+
+    void Submit(std::function<void()> task);
+
+    // Runs queued tasks on the calling thread until pendingTasks drops to zero
+    void Wait(const std::atomic<int>& pendingTasks);
+
+    // Splits [0, count) into chunks of chunkSize and calls func(begin, end) once per chunk. The workers
+    // and the calling thread keep claiming chunks until none are left, and the call returns when all are done.
+    template<typename TFunc>
+    void ParallelFor(int count, int chunkSize, TFunc&& func);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// ThreadLocalBuffers
+////////////////////////////////////////////////////////////////////////////////
+// One T per thread of a pool, so a parallel pass can collect results (kill
+// lists, render packets...) without locking. The caller merges them once the
+// pass is over. Non-worker threads share a slot, so only the thread that drives
+// the pass may take part besides the workers. Without a pool there is one slot.
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class ThreadLocalBuffers
+{
+private:
+    // Padded to a cache line so neighbouring threads do not false-share
+    struct alignas(64) Slot
+    {
+        T value;
+    };
+
+    const ThreadPool* threadPool;
+    std::vector<Slot> slots;
+
+public:
+    explicit ThreadLocalBuffers(const ThreadPool* threadPool) : threadPool(threadPool), slots(threadPool ? threadPool->GetWorkerCount() + 1 : 1) { };
+
+    // The buffer of the calling thread
+    T& Local()
+    {
+        return slots[threadPool ? threadPool->GetCurrentThreadIndex() : 0].value;
+    }
+
+    // Calls func(buffer) for the buffer of every thread, in thread order
+    template<typename TFunc>
+    void ForEach(TFunc&& func)
+    {
+        for (auto& slot : slots)
+        {
+            func(slot.value);
+        }
+    }
+};
+
+template<typename TFunc>
+void ThreadPool::ParallelFor(int count, int chunkSize, TFunc&& func)
+{
+    chunkSize = std::max(chunkSize, 1);
+    const int chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (chunkCount <= 1 || workers.empty())
+    {
+        if (count > 0)
+        {
+            func(0, count);
+        }
+        return;
+    }
+
+    // Chunks are claimed from a shared counter, so faster threads simply take more of them
+    std::atomic<int> nextChunk(0);
+    auto runChunks = [&]()
+    {
+        for (int chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+        {
+            const int begin = chunk * chunkSize;
+            func(begin, std::min(begin + chunkSize, count));
+        }
+    };
+
+    // One helper task per worker that could get a chunk, the calling thread works through chunks as well
+    const int helperCount = std::min(chunkCount - 1, static_cast<int>(workers.size()));
+    std::atomic<int> pendingHelpers(helperCount);
+    for (int i = 0; i < helperCount; i++)
+    {
+        Submit([&runChunks, &pendingHelpers]()
+        {
+            runChunks();
+            pendingHelpers--;
+        });
+    }
+
+    runChunks();
+    Wait(pendingHelpers);
+}
+
+#endif
@@ -0,0 +1,321 @@
+#include "../Source/Broadphase/Broadphase.h"
+#include "../Source/Broadphase/DynamicAABBTree.h"
+#include "../Source/Broadphase/SpatialHashGrid.h"
+#include "../Source/Broadphase/SweepAndPrune.h"
+#include "TestChecks.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// BroadphaseTest
+////////////////////////////////////////////////////////////////////////////////
+// Plays random frames of colliders that move, teleport, spawn on new or freed
+// keys, despawn, change layers and come in a new order, with boxes that touch
+// exactly and boxes too large for the grid. Checks that every broadphase,
+// kept from frame to frame, finds exactly the pairs of the brute force
+// reference, and that the region queries of the AABB tree find exactly the
+// boxes a linear pass finds.
+////////////////////////////////////////////////////////////////////////////////
+
+struct Collider
+{
+    int key;
+    AABB box;
+    CollisionFilter filter;
+    float velocityX;
+    float velocityY;
+};
+
+// The boxes of a frame as the collision system hands them to a broadphase
+struct Frame
+{
+    std::vector<AABB> boxes;
+    std::vector<int> keys;
+    std::vector<CollisionFilter> filters;
+};
+
+class World
+{
+private:
+    std::mt19937 random;
+    std::vector<Collider> colliders;
+    std::vector<int> freeKeys;
+    int nextKey = 0;
+
+    // Coordinates in whole pixels, so many boxes touch exactly
+    float RandomCoordinate(int range)
+    {
+        return static_cast<float>(static_cast<int>(random() % range));
+    }
+
+    CollisionFilter RandomFilter()
+    {
+        // Mostly the default filter, as in the game, and some of three layers with masks that leave some out
+        if (random() % 4 != 0)
+        {
+            return { 1, 0xFFFFFFFF };
+        }
+        const uint32_t layer = 1u << (random() % 3);
+        return { layer, static_cast<uint32_t>(random() % 8) };
+    }
+
+    AABB RandomBox()
+    {
+        const float x = RandomCoordinate(1000) - 100.0f;
+        const float y = RandomCoordinate(800) - 100.0f;
+
+        // A few boxes cover more cells than the grid takes, and some have zero size
+        const bool isOversized = random() % 40 == 0;
+        const float width = isOversized ? 600.0f + RandomCoordinate(400) : RandomCoordinate(48);
+        const float height = isOversized ? 600.0f + RandomCoordinate(400) : RandomCoordinate(48);
+        return { x, y, x + width, y + height };
+    }
+
+    void Spawn()
+    {
+        // Freed keys are reused, like the entity ids they stand for
+        int key = nextKey;
+        if (!freeKeys.empty() && random() % 2 == 0)
+        {
+            key = freeKeys.back();
+            freeKeys.pop_back();
+        }
+        else
+        {
+            nextKey++;
+        }
+
+        const float velocityX = static_cast<float>(static_cast<int>(random() % 7) - 3);
+        const float velocityY = static_cast<float>(static_cast<int>(random() % 7) - 3);
+        colliders.push_back({ key, RandomBox(), RandomFilter(), velocityX, velocityY });
+    }
+
+public:
+    explicit World(unsigned int seed) : random(seed) { }
+
+    void Populate(int colliderCount)
+    {
+        for (int i = 0; i < colliderCount; i++)
+        {
+            Spawn();
+        }
+    }
+
+    // Moves every collider, and spawns, despawns, teleports, refilters and reorders some
+    void Step()
+    {
+        for (auto& collider : colliders)
+        {
+            collider.box.minX += collider.velocityX;
+            collider.box.maxX += collider.velocityX;
+            collider.box.minY += collider.velocityY;
+            collider.box.maxY += collider.velocityY;
+
+            switch (random() % 50)
+            {
+                case 0: collider.box = RandomBox(); break;
+                case 1: collider.filter = RandomFilter(); break;
+            }
+        }
+
+        for (int i = 0; i < static_cast<int>(colliders.size()); i++)
+        {
+            if (random() % 20 == 0)
+            {
+                freeKeys.push_back(colliders[i].key);
+                colliders[i] = colliders.back();
+                colliders.pop_back();
+                i--;
+            }
+        }
+
+        const int spawnCount = random() % 12;
+        for (int i = 0; i < spawnCount; i++)
+        {
+            Spawn();
+        }
+
+        if (random() % 4 == 0)
+        {
+            std::shuffle(colliders.begin(), colliders.end(), random);
+        }
+    }
+
+    void Clear()
+    {
+        for (const auto& collider : colliders)
+        {
+            freeKeys.push_back(collider.key);
+        }
+        colliders.clear();
+    }
+
+    Frame GetFrame() const
+    {
+        Frame frame;
+        for (const auto& collider : colliders)
+        {
+            frame.boxes.push_back(collider.box);
+            frame.keys.push_back(collider.key);
+            frame.filters.push_back(collider.filter);
+        }
+        return frame;
+    }
+};
+
+static std::vector<BroadphasePair> FindSortedPairs(IBroadphase& broadphase, const Frame& frame)
+{
+    std::vector<BroadphasePair> pairs;
+    broadphase.FindPairs(frame.boxes, frame.keys, frame.filters, pairs);
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+static bool operator ==(const BroadphasePair& a, const BroadphasePair& b)
+{
+    return a.first == b.first && a.second == b.second;
+}
+
+static void TestPairs()
+{
+    SpatialHashGrid spatialHash;
+    SweepAndPrune sweepAndPrune;
+    DynamicAABBTree aabbTree;
+    BruteForceBroadphase bruteForce;
+
+    // Small cells as well, so the grid also meets boxes of many cells
+    SpatialHashGrid smallCellSpatialHash(16.0f);
+
+    World world(11);
+    world.Populate(300);
+    bool isSpatialHashExact = true;
+    bool isSmallCellSpatialHashExact = true;
+    bool isSweepAndPruneExact = true;
+    bool isAABBTreeExact = true;
+    bool isPairCountNonZero = false;
+    for (int frameIndex = 0; frameIndex < 300; frameIndex++)
+    {
+        // An empty frame in the middle removes every box the broadphases keep
+        if (frameIndex == 150)
+        {
+            world.Clear();
+        }
+        else if (frameIndex == 151)
+        {
+            world.Populate(300);
+        }
+        else
+        {
+            world.Step();
+        }
+
+        const Frame frame = world.GetFrame();
+        const std::vector<BroadphasePair> expected = FindSortedPairs(bruteForce, frame);
+        isPairCountNonZero |= !expected.empty();
+        isSpatialHashExact &= FindSortedPairs(spatialHash, frame) == expected;
+        isSmallCellSpatialHashExact &= FindSortedPairs(smallCellSpatialHash, frame) == expected;
+        isSweepAndPruneExact &= FindSortedPairs(sweepAndPrune, frame) == expected;
+        isAABBTreeExact &= FindSortedPairs(aabbTree, frame) == expected;
+        isAABBTreeExact &= aabbTree.GetStats().leafCount == static_cast<int>(frame.boxes.size());
+    }
+    Check(isPairCountNonZero, "the frames hold overlapping boxes");
+    Check(isSpatialHashExact, "the spatial hash finds the pairs of the brute force broadphase");
+    Check(isSmallCellSpatialHashExact, "the spatial hash with small cells finds the pairs of the brute force broadphase");
+    Check(isSweepAndPruneExact, "sweep and prune finds the pairs of the brute force broadphase");
+    Check(isAABBTreeExact, "the AABB tree finds the pairs of the brute force broadphase and holds one leaf per box");
+}
+
+static void TestFilters()
+{
+    // Four boxes on one spot, a pair only collides if each one has a layer of the other in its mask
+    const std::vector<AABB> boxes(4, AABB{ 0.0f, 0.0f, 10.0f, 10.0f });
+    const std::vector<int> keys = { 0, 1, 2, 3 };
+    const std::vector<CollisionFilter> filters = {
+        { 1, 2 },           // takes layer 2, but 2 does not take layer 1
+        { 2, 3 },           // takes layers 1 and 2
+        { 2, 2 },           // takes layer 2
+        { 4, 0xFFFFFFFF }   // takes every layer, but no other box takes layer 4
+    };
+    const std::vector<BroadphasePair> expected = { { 0, 1 }, { 1, 2 } };
+
+    BruteForceBroadphase bruteForce;
+    SpatialHashGrid spatialHash;
+    SweepAndPrune sweepAndPrune;
+    DynamicAABBTree aabbTree;
+    const Frame frame = { boxes, keys, filters };
+    Check(FindSortedPairs(bruteForce, frame) == expected, "the brute force broadphase pairs boxes whose filters take each other");
+    Check(FindSortedPairs(spatialHash, frame) == expected, "the spatial hash pairs boxes whose filters take each other");
+    Check(FindSortedPairs(sweepAndPrune, frame) == expected, "sweep and prune pairs boxes whose filters take each other");
+    Check(FindSortedPairs(aabbTree, frame) == expected, "the AABB tree pairs boxes whose filters take each other");
+}
+
+static void TestQueries()
+{
+    std::mt19937 random(5);
+    DynamicAABBTree aabbTree;
+    World world(17);
+    world.Populate(500);
+
+    bool isEveryQueryExact = true;
+    bool isKeyOfEveryBoxGiven = true;
+    bool isHeightLogarithmic = true;
+    for (int frameIndex = 0; frameIndex < 100; frameIndex++)
+    {
+        world.Step();
+        const Frame frame = world.GetFrame();
+        aabbTree.Update(frame.boxes, frame.keys);
+
+        const int boxCount = static_cast<int>(frame.boxes.size());
+        isHeightLogarithmic &= aabbTree.GetStats().height <= 2 * static_cast<int>(std::log2(std::max(boxCount, 1))) + 2;
+
+        for (int query = 0; query < 10; query++)
+        {
+            // Regions from a point to larger than the camera
+            const float x = static_cast<float>(static_cast<int>(random() % 1000) - 100);
+            const float y = static_cast<float>(static_cast<int>(random() % 800) - 100);
+            const float size = static_cast<float>(random() % 2 == 0 ? random() % 64 : random() % 900);
+            const AABB region = { x, y, x + size, y + size * 0.75f };
+
+            std::vector<int> found;
+            aabbTree.Query(region, [&](int boxIndex, int key)
+            {
+                found.push_back(boxIndex);
+                isKeyOfEveryBoxGiven &= boxIndex >= 0 && boxIndex < boxCount && frame.keys[boxIndex] == key;
+            });
+            std::sort(found.begin(), found.end());
+
+            std::vector<int> expected;
+            for (int boxIndex = 0; boxIndex < boxCount; boxIndex++)
+            {
+                if (Overlaps(frame.boxes[boxIndex], region))
+                {
+                    expected.push_back(boxIndex);
+                }
+            }
+            isEveryQueryExact &= found == expected;
+        }
+    }
+    Check(isEveryQueryExact, "region queries find the boxes a linear pass finds, each once");
+    Check(isKeyOfEveryBoxGiven, "region queries give the key of each box found");
+    Check(isHeightLogarithmic, "the AABB tree stays balanced");
+
+    DynamicAABBTree emptyTree;
+    bool isAnyBoxFound = false;
+    emptyTree.Query({ 0.0f, 0.0f, 100.0f, 100.0f }, [&](int, int)
+    {
+        isAnyBoxFound = true;
+    });
+    Check(!isAnyBoxFound, "an empty tree finds no box");
+}
+
+int main()
+{
+    TestPairs();
+    TestFilters();
+    TestQueries();
+
+    return ReportChecks("broadphase");
+}
@@ -0,0 +1,122 @@
+#include "../Source/ECS/ECS.h"
+#include "TestChecks.h"
+#include <set>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// EntityHandleTest
+////////////////////////////////////////////////////////////////////////////////
+// Kills entities and creates new ones on their recycled ids. Checks that a
+// reused id gets a new generation, that stale handles are no longer alive and
+// cannot kill, tag or group the entity now using their id, and that killing
+// twice frees the id only once.
+////////////////////////////////////////////////////////////////////////////////
+
+struct Health { int value = 0; };
+
+class HealthSystem : public System
+{
+public:
+    HealthSystem()
+    {
+        RequireComponent<Health>();
+    }
+};
+
+static bool IsInSystem(Registry& registry, Entity entity)
+{
+    for (Entity systemEntity : registry.GetSystem<HealthSystem>().GetSystemEntities())
+    {
+        if (systemEntity == entity)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void TestReuse()
+{
+    Registry registry;
+    registry.AddSystem<HealthSystem>();
+    Entity first = registry.CreateEntity();
+    first.AddComponent<Health>(Health{ 10 });
+    registry.Update();
+
+    first.Kill();
+    Check(first.IsAlive(), "a killed entity stays alive until the next Update()");
+    registry.Update();
+    Check(!first.IsAlive(), "a killed entity is not alive after the next Update()");
+
+    Entity second = registry.CreateEntity();
+    second.AddComponent<Health>(Health{ 20 });
+    registry.Update();
+    Check(second.GetId() == first.GetId(), "a freed id is reused by the next new entity");
+    Check(second.GetGeneration() == first.GetGeneration() + 1, "a reused id gets the next generation");
+    Check(second != first, "handles to different generations of an id are not equal");
+    Check(second.IsAlive() && !first.IsAlive(), "the stale handle is not alive, the new one is");
+    Check(registry.GetEntityById(second.GetId()) == second, "GetEntityById returns the handle of the current generation");
+    Check(IsInSystem(registry, second) && !IsInSystem(registry, first), "systems hold the handle of the current generation");
+
+    first.Kill();
+    registry.Update();
+    Check(second.IsAlive(), "killing through a stale handle leaves the entity now using the id alive");
+    Check(second.ReadComponent<Health>().value == 20, "killing through a stale handle leaves the components of the new entity alone");
+
+    second.Tag("player");
+    second.Group("allies");
+    Check(!first.HasTag("player") && second.HasTag("player"), "a stale handle does not have the tag of the entity now using its id");
+    Check(!first.BelongsToGroup("allies") && second.BelongsToGroup("allies"), "a stale handle does not belong to the groups of the entity now using its id");
+
+    Check(!registry.GetEntityById(-1).IsAlive(), "an id below zero gives a handle that is not alive");
+    Check(!registry.GetEntityById(1000).IsAlive(), "an id that was never created gives a handle that is not alive");
+}
+
+static void TestFreeOrder()
+{
+    Registry registry;
+    std::vector<Entity> entities;
+    for (int i = 0; i < 4; i++)
+    {
+        entities.push_back(registry.CreateEntity());
+    }
+    registry.Update();
+
+    // Killing twice in a frame must free the id once, or two new entities would share it
+    entities[1].Kill();
+    entities[1].Kill();
+    entities[2].Kill();
+    registry.Update();
+
+    Entity reusedFirst = registry.CreateEntity();
+    Entity reusedSecond = registry.CreateEntity();
+    Entity fresh = registry.CreateEntity();
+    registry.Update();
+    Check(reusedFirst.GetId() == entities[1].GetId() && reusedSecond.GetId() == entities[2].GetId(), "ids freed in the same frame are reused in the order they were killed");
+    Check(fresh.GetId() == 4, "an entity killed twice frees its id once");
+
+    const std::set<int> ids = { entities[0].GetId(), reusedFirst.GetId(), reusedSecond.GetId(), entities[3].GetId(), fresh.GetId() };
+    Check(ids.size() == 5, "live entities never share an id");
+
+    // Ids can be recycled many times, and every generation is new
+    Entity entity = entities[3];
+    bool isEveryGenerationNew = true;
+    for (int i = 0; i < 100; i++)
+    {
+        entity.Kill();
+        registry.Update();
+        Entity recycled = registry.CreateEntity();
+        registry.Update();
+        isEveryGenerationNew &= recycled.GetId() == entity.GetId() && recycled.GetGeneration() == entity.GetGeneration() + 1 && !entity.IsAlive();
+        entity = recycled;
+    }
+    Check(isEveryGenerationNew, "every recycling of an id gives a new generation");
+}
+
+int main()
+{
+    TestReuse();
+    TestFreeOrder();
+
+    return ReportChecks("entity handle");
+}
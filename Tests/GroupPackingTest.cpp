@@ -0,0 +1,180 @@
+#include "../Source/ECS/ECS.h"
+#include "TestChecks.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// GroupPackingTest
+////////////////////////////////////////////////////////////////////////////////
+// Adds, removes and kills components of entities in an owning group, also
+// through prefabs and snapshots. Every component stores the id of its entity,
+// so a group iteration that hands out components of another entity (a pool
+// packed out of order) is caught, as is an entity visited twice, or missing
+// from the group, or left in it.
+////////////////////////////////////////////////////////////////////////////////
+
+struct Position { int entityId = -1; };
+struct Velocity { int entityId = -1; };
+struct Sprite { int entityId = -1; };
+
+// True if the group visits exactly the live entities with all three components, each once and with its own components
+static bool IsGroupPacked(Registry& registry)
+{
+    std::vector<int> expected;
+    registry.View<const Position, const Velocity, const Sprite>().Each([&](Entity entity, const Position&, const Velocity&, const Sprite&)
+    {
+        expected.push_back(entity.GetId());
+    });
+
+    bool isOwnComponents = true;
+    std::vector<int> visited;
+    registry.Group<Position, const Velocity>(Observed<const Sprite>()).Each([&](Entity entity, Position& position, const Velocity& velocity, const Sprite& sprite)
+    {
+        const int entityId = entity.GetId();
+        visited.push_back(entityId);
+        isOwnComponents &= position.entityId == entityId && velocity.entityId == entityId && sprite.entityId == entityId;
+    });
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(visited.begin(), visited.end());
+    return isOwnComponents && visited == expected;
+}
+
+static Entity CreateMover(Registry& registry, bool hasSprite)
+{
+    Entity entity = registry.CreateEntity();
+    entity.AddComponent<Position>(Position{ entity.GetId() });
+    entity.AddComponent<Velocity>(Velocity{ entity.GetId() });
+    if (hasSprite)
+    {
+        entity.AddComponent<Sprite>(Sprite{ entity.GetId() });
+    }
+    return entity;
+}
+
+static void TestAddRemoveKill()
+{
+    Registry registry;
+
+    // Entities that exist before the declaration are packed by it
+    std::vector<Entity> entities;
+    for (int i = 0; i < 30; i++)
+    {
+        entities.push_back(CreateMover(registry, i % 2 == 0));
+    }
+    registry.Update();
+    registry.DeclareGroup<Position, Velocity>(Observed<Sprite>());
+    Check(IsGroupPacked(registry), "declaring a group packs the entities that already match it");
+
+    entities[1].AddComponent<Sprite>(Sprite{ entities[1].GetId() });
+    entities[3].AddComponent<Sprite>(Sprite{ entities[3].GetId() });
+    Check(IsGroupPacked(registry), "adding the last observed component packs the entity");
+
+    entities[0].RemoveComponent<Velocity>();
+    entities[4].RemoveComponent<Position>();
+    Check(IsGroupPacked(registry), "removing an owned component unpacks the entity");
+
+    entities[6].RemoveComponent<Sprite>();
+    Check(IsGroupPacked(registry), "removing an observed component unpacks the entity");
+
+    entities[0].AddComponent<Velocity>(Velocity{ entities[0].GetId() });
+    entities[8].AddComponent<Position>(Position{ entities[8].GetId() });
+    Check(IsGroupPacked(registry), "replacing an owned component keeps the entity packed once");
+
+    for (int i = 0; i < 30; i += 5)
+    {
+        entities[i].Kill();
+    }
+    registry.Update();
+    Check(IsGroupPacked(registry), "killed entities are unpacked");
+
+    // New entities reuse the killed ids, in and out of the group
+    for (int i = 0; i < 10; i++)
+    {
+        CreateMover(registry, i % 3 != 0);
+    }
+    registry.Update();
+    Check(IsGroupPacked(registry), "entities created on freed ids are packed");
+}
+
+static void TestPrefabsAndSnapshots()
+{
+    Registry registry;
+    registry.DeclareGroup<Position, Velocity>(Observed<Sprite>());
+
+    // Prefab components hold no entity id, so the copies get theirs afterwards
+    Prefab prefab;
+    prefab
+        .AddComponent<Position>()
+        .AddComponent<Velocity>()
+        .AddComponent<Sprite>();
+    for (Entity entity : registry.Instantiate(prefab, 50))
+    {
+        entity.GetComponent<Position>().entityId = entity.GetId();
+        entity.GetComponent<Velocity>().entityId = entity.GetId();
+        entity.GetComponent<Sprite>().entityId = entity.GetId();
+    }
+    for (int i = 0; i < 10; i++)
+    {
+        CreateMover(registry, false);
+    }
+    registry.Update();
+    Check(IsGroupPacked(registry), "instantiated prefabs are packed");
+
+    const std::vector<std::byte> snapshot = registry.Snapshot();
+    for (int entityId = 0; entityId < 60; entityId += 3)
+    {
+        registry.GetEntityById(entityId).Kill();
+    }
+    registry.Update();
+    Check(registry.Restore(snapshot) && IsGroupPacked(registry), "a restored world is packed again");
+}
+
+static void TestRandomFrames()
+{
+    Registry registry;
+    registry.DeclareGroup<Position, Velocity>(Observed<Sprite>());
+    std::mt19937 random(3);
+    std::vector<Entity> entities;
+
+    bool isPackedEveryFrame = true;
+    for (int frame = 0; frame < 200; frame++)
+    {
+        for (int i = 0; i < 20; i++)
+        {
+            if (entities.empty() || random() % 6 == 0)
+            {
+                entities.push_back(CreateMover(registry, random() % 2 == 0));
+            }
+            Entity entity = entities[random() % entities.size()];
+            if (!entity.IsAlive())
+            {
+                continue;
+            }
+            switch (random() % 7)
+            {
+                case 0: entity.AddComponent<Position>(Position{ entity.GetId() }); break;
+                case 1: entity.AddComponent<Velocity>(Velocity{ entity.GetId() }); break;
+                case 2: entity.AddComponent<Sprite>(Sprite{ entity.GetId() }); break;
+                case 3: if (entity.HasComponent<Position>()) { entity.RemoveComponent<Position>(); } break;
+                case 4: if (entity.HasComponent<Velocity>()) { entity.RemoveComponent<Velocity>(); } break;
+                case 5: if (entity.HasComponent<Sprite>()) { entity.RemoveComponent<Sprite>(); } break;
+                case 6: entity.Kill(); break;
+            }
+        }
+        isPackedEveryFrame &= IsGroupPacked(registry);
+        registry.Update();
+        isPackedEveryFrame &= IsGroupPacked(registry);
+    }
+    Check(isPackedEveryFrame, "the group stays packed through random adds, removes and kills");
+}
+
+int main()
+{
+    TestAddRemoveKill();
+    TestPrefabsAndSnapshots();
+    TestRandomFrames();
+
+    return ReportChecks("group packing");
+}
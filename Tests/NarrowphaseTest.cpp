@@ -0,0 +1,221 @@
+#include "../Source/Narrowphase/Narrowphase.h"
+#include "TestChecks.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// NarrowphaseTest
+////////////////////////////////////////////////////////////////////////////////
+// Checks that every AABB kernel the CPU supports gives exactly the results of
+// the scalar kernel, and that the scalar kernel follows the overlap rule: edges
+// excluded, so touching boxes do not overlap.
+////////////////////////////////////////////////////////////////////////////////
+
+static bool ReferenceOverlap(const AABB& a, const AABB& b)
+{
+    return a.minX < b.maxX && a.maxX > b.minX && a.minY < b.maxY && a.maxY > b.minY;
+}
+
+// Runs a kernel over [begin, end) of the candidates, with guard bytes around the range so writes outside it show
+static std::vector<uint8_t> RunKernel(AABBKernel kernel, const AABB& box, const AABBArrays& candidates, int begin, int end)
+{
+    const uint8_t GUARD = 0xAB;
+    std::vector<uint8_t> overlaps(candidates.GetSize() + 1, GUARD);
+    TestAABBOverlaps(kernel, box, candidates, begin, end, overlaps.data());
+    for (int i = 0; i < static_cast<int>(overlaps.size()); i++)
+    {
+        if (i < begin || i >= end)
+        {
+            Check(overlaps[i] == GUARD, "kernel writes outside of its range");
+        }
+    }
+    return overlaps;
+}
+
+// Compares every supported kernel with the scalar one, and the scalar one with the reference rule
+static void CheckKernels(const AABB& box, const AABBArrays& candidates, int begin, int end, const char* description)
+{
+    const std::vector<uint8_t> expected = RunKernel(AABB_KERNEL_SCALAR, box, candidates, begin, end);
+    for (int i = begin; i < end; i++)
+    {
+        const AABB candidate = { candidates.minX[i], candidates.minY[i], candidates.maxX[i], candidates.maxY[i] };
+        if (expected[i] != (ReferenceOverlap(box, candidate) ? 1 : 0))
+        {
+            std::printf("FAILED: scalar kernel disagrees with the overlap rule (%s)\n", description);
+            failureCount++;
+        }
+    }
+
+    for (int kernel = AABB_KERNEL_SCALAR + 1; kernel < AABB_KERNEL_COUNT; kernel++)
+    {
+        if (!IsAABBKernelSupported(static_cast<AABBKernel>(kernel)))
+        {
+            continue;
+        }
+        if (RunKernel(static_cast<AABBKernel>(kernel), box, candidates, begin, end) != expected)
+        {
+            std::printf("FAILED: %s kernel differs from the scalar kernel (%s)\n", GetAABBKernelName(static_cast<AABBKernel>(kernel)), description);
+            failureCount++;
+        }
+    }
+}
+
+static AABBArrays MakeArrays(const std::vector<AABB>& boxes)
+{
+    AABBArrays arrays;
+    arrays.Resize(static_cast<int>(boxes.size()));
+    for (int i = 0; i < static_cast<int>(boxes.size()); i++)
+    {
+        arrays.Set(i, boxes[i]);
+    }
+    return arrays;
+}
+
+static void TestEdgeCases()
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float infinity = std::numeric_limits<float>::infinity();
+    const AABB box = { 0.0f, 0.0f, 10.0f, 10.0f };
+
+    // One candidate per case, 11 in all so the SIMD kernels also run their tail
+    const std::vector<AABB> candidates = {
+        { 10.0f, 0.0f, 20.0f, 10.0f },         // touches the right edge
+        { -10.0f, 0.0f, 0.0f, 10.0f },         // touches the left edge
+        { 0.0f, 10.0f, 10.0f, 20.0f },         // touches the bottom edge
+        { 10.0f, 10.0f, 20.0f, 20.0f },        // touches a corner
+        { 5.0f, 5.0f, 5.0f, 5.0f },            // zero size, inside
+        { 10.0f, 5.0f, 10.0f, 5.0f },          // zero size, on the edge
+        { 2.0f, 2.0f, 8.0f, 8.0f },            // inside
+        { 9.5f, 9.5f, 30.0f, 30.0f },          // overlaps a corner
+        { nan, 0.0f, 5.0f, 5.0f },             // NaN coordinate
+        { 0.0f, 0.0f, nan, nan },              // NaN coordinates
+        { -infinity, -infinity, infinity, infinity }
+    };
+    const std::vector<uint8_t> expected = { 0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1 };
+
+    const AABBArrays arrays = MakeArrays(candidates);
+    for (int kernel = 0; kernel < AABB_KERNEL_COUNT; kernel++)
+    {
+        if (!IsAABBKernelSupported(static_cast<AABBKernel>(kernel)))
+        {
+            continue;
+        }
+        std::vector<uint8_t> overlaps = RunKernel(static_cast<AABBKernel>(kernel), box, arrays, 0, arrays.GetSize());
+        overlaps.pop_back();
+        Check(overlaps == expected, "edge cases give the expected overlaps");
+    }
+    CheckKernels(box, arrays, 0, arrays.GetSize(), "edge cases");
+
+    // A box with a NaN coordinate overlaps nothing
+    CheckKernels({ nan, 0.0f, 10.0f, 10.0f }, arrays, 0, arrays.GetSize(), "NaN box");
+
+    // Empty range
+    CheckKernels(box, arrays, 3, 3, "empty range");
+}
+
+static void TestRandomBoxes()
+{
+    std::mt19937 random(2024);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    // Coordinates on a coarse grid, so many boxes touch exactly and some have zero size
+    auto randomCoordinate = [&]()
+    {
+        if (random() % 50 == 0)
+        {
+            return nan;
+        }
+        return static_cast<float>(random() % 17) * 0.5f;
+    };
+    auto randomBox = [&]()
+    {
+        const float x = randomCoordinate();
+        const float y = randomCoordinate();
+        return AABB{ x, y, x + randomCoordinate(), y + randomCoordinate() };
+    };
+
+    for (int iteration = 0; iteration < 20000; iteration++)
+    {
+        // Counts and offsets that are not multiples of the SIMD widths
+        const int count = random() % 40;
+        std::vector<AABB> boxes(count);
+        std::generate(boxes.begin(), boxes.end(), randomBox);
+        const AABBArrays arrays = MakeArrays(boxes);
+
+        const int begin = count > 0 ? random() % (count + 1) : 0;
+        const int end = begin + random() % (count - begin + 1);
+        CheckKernels(randomBox(), arrays, begin, end, "random boxes");
+    }
+}
+
+static void TestPairs()
+{
+    std::mt19937 random(7);
+    for (int iteration = 0; iteration < 200; iteration++)
+    {
+        const int boxCount = 1 + random() % 200;
+        std::vector<AABB> boxes(boxCount);
+        for (auto& box : boxes)
+        {
+            const float x = static_cast<float>(random() % 400);
+            const float y = static_cast<float>(random() % 400);
+            box = { x, y, x + random() % 40, y + random() % 40 };
+        }
+
+        std::vector<BroadphasePair> pairs;
+        for (int i = 0; i < boxCount * 3; i++)
+        {
+            const int a = random() % boxCount;
+            const int b = random() % boxCount;
+            if (a != b)
+            {
+                pairs.push_back({ std::min(a, b), std::max(a, b) });
+            }
+        }
+        if (iteration % 2 == 0)
+        {
+            std::sort(pairs.begin(), pairs.end());
+        }
+
+        Narrowphase scalar;
+        scalar.SetKernel(AABB_KERNEL_SCALAR);
+        std::vector<uint8_t> expected;
+        scalar.TestPairs(boxes, pairs, expected);
+        for (int i = 0; i < static_cast<int>(pairs.size()); i++)
+        {
+            Check(expected[i] == (ReferenceOverlap(boxes[pairs[i].first], boxes[pairs[i].second]) ? 1 : 0), "TestPairs follows the overlap rule");
+        }
+
+        for (int kernel = AABB_KERNEL_SCALAR + 1; kernel < AABB_KERNEL_COUNT; kernel++)
+        {
+            if (!IsAABBKernelSupported(static_cast<AABBKernel>(kernel)))
+            {
+                continue;
+            }
+            Narrowphase narrowphase;
+            narrowphase.SetKernel(static_cast<AABBKernel>(kernel));
+            std::vector<uint8_t> overlaps;
+            narrowphase.TestPairs(boxes, pairs, overlaps);
+            Check(overlaps == expected, "TestPairs gives the same results with every kernel");
+        }
+    }
+}
+
+int main()
+{
+    for (int kernel = 0; kernel < AABB_KERNEL_COUNT; kernel++)
+    {
+        std::printf("%s kernel: %s\n", GetAABBKernelName(static_cast<AABBKernel>(kernel)),
+            IsAABBKernelSupported(static_cast<AABBKernel>(kernel)) ? "tested" : "not supported by this CPU, skipped");
+    }
+
+    TestEdgeCases();
+    TestRandomBoxes();
+    TestPairs();
+
+    return ReportChecks("narrowphase");
+}
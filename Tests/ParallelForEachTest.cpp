@@ -0,0 +1,220 @@
+#include "../Source/ECS/ECS.h"
+#include "../Source/ThreadPool/ThreadPool.h"
+#include "TestChecks.h"
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// ParallelForEachTest
+////////////////////////////////////////////////////////////////////////////////
+// Runs the chunked parallel iterations (views and system entities) on a pool
+// with several workers. Checks that every entity is visited exactly once, that
+// kills from workers and entities created through per-thread command buffers
+// are applied by the next Update(), and that the world ends up exactly as with
+// no pool.
+////////////////////////////////////////////////////////////////////////////////
+
+struct Position { int32_t x = 0; };
+struct Velocity { int32_t dx = 0; };
+struct Spawned { int32_t parentId = 0; };
+
+class MovingSystem : public System
+{
+public:
+    MovingSystem()
+    {
+        RequireComponent<Position>();
+        RequireComponent<Velocity>();
+    }
+};
+
+const int ENTITY_COUNT = 5000;
+const int CHUNK_SIZE = 64;
+
+static void Populate(Registry& registry)
+{
+    registry.AddSystem<MovingSystem>();
+    for (int i = 0; i < ENTITY_COUNT; i++)
+    {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<Position>(Position{ i });
+        if (i % 5 != 0)
+        {
+            entity.AddComponent<Velocity>(Velocity{ i % 7 - 3 });
+        }
+    }
+    registry.Update();
+}
+
+// Sorted ids of the entities visited by a pass, gathered per thread
+static std::vector<int> MergeIds(ThreadLocalBuffers<std::vector<int>>& visitedIds)
+{
+    std::vector<int> ids;
+    visitedIds.ForEach([&](std::vector<int>& threadIds)
+    {
+        ids.insert(ids.end(), threadIds.begin(), threadIds.end());
+    });
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// One frame: integrate through a view, kill the entities that leave [0, ENTITY_COUNT), and spawn a child next to
+// every entity standing one past a multiple of 100. Returns the sorted ids visited by the view.
+static std::vector<int> RunFrame(Registry& registry, ThreadPool* threadPool)
+{
+    ThreadLocalBuffers<std::vector<int>> visitedIds(threadPool);
+    ThreadLocalBuffers<CommandBuffer> commandBuffers(threadPool);
+
+    registry.View<Position, const Velocity>().ParallelForEach(CHUNK_SIZE, [&](Entity entity, Position& position, const Velocity& velocity)
+    {
+        visitedIds.Local().push_back(entity.GetId());
+        position.x += velocity.dx * 50;
+        if (position.x < 0 || position.x >= ENTITY_COUNT)
+        {
+            entity.Kill();
+        }
+        else if (position.x % 100 == 1)
+        {
+            CommandBuffer& commandBuffer = commandBuffers.Local();
+            Entity child = commandBuffer.CreateEntity();
+            commandBuffer.AddComponent<Position>(child, Position{ position.x });
+            commandBuffer.AddComponent<Spawned>(child, Spawned{ entity.GetId() });
+        }
+    });
+
+    commandBuffers.ForEach([&](CommandBuffer& commandBuffer)
+    {
+        registry.SubmitCommandBuffer(commandBuffer);
+    });
+    registry.Update();
+    return MergeIds(visitedIds);
+}
+
+// Expected ids of a view pass: every entity that has both components, once
+static std::vector<int> GetExpectedIds(Registry& registry)
+{
+    std::vector<int> ids;
+    registry.View<const Position, const Velocity>().Each([&](Entity entity, const Position&, const Velocity&)
+    {
+        ids.push_back(entity.GetId());
+    });
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static int CountSpawned(Registry& registry)
+{
+    int count = 0;
+    registry.View<const Spawned>().Each([&](const Spawned&)
+    {
+        count++;
+    });
+    return count;
+}
+
+// Sorted (id, position, parent id) of every entity. Spawned entities get their ids in the order the threads recorded
+// them, so they are listed by parent instead of by id.
+static std::vector<std::tuple<int, int32_t, int32_t>> GetWorld(Registry& registry)
+{
+    std::vector<std::tuple<int, int32_t, int32_t>> world;
+    registry.View<const Position>().Each([&](Entity entity, const Position& position)
+    {
+        if (entity.HasComponent<Spawned>())
+        {
+            world.emplace_back(-1, position.x, entity.ReadComponent<Spawned>().parentId);
+        }
+        else
+        {
+            world.emplace_back(entity.GetId(), position.x, -1);
+        }
+    });
+    std::sort(world.begin(), world.end());
+    return world;
+}
+
+static void TestViewFrames()
+{
+    ThreadPool threadPool(3);
+    Registry parallelRegistry;
+    Registry serialRegistry;
+    parallelRegistry.SetThreadPool(&threadPool);
+    Populate(parallelRegistry);
+    Populate(serialRegistry);
+
+    bool isAnyKilled = false;
+    bool isAnySpawned = false;
+    for (int frame = 0; frame < 20; frame++)
+    {
+        const std::vector<int> expectedIds = GetExpectedIds(parallelRegistry);
+        std::vector<Entity> entities;
+        for (int entityId : expectedIds)
+        {
+            entities.push_back(parallelRegistry.GetEntityById(entityId));
+        }
+        const int spawnedBefore = CountSpawned(parallelRegistry);
+
+        Check(RunFrame(parallelRegistry, &threadPool) == expectedIds, "a parallel view pass visits every matching entity exactly once");
+        RunFrame(serialRegistry, nullptr);
+
+        isAnySpawned |= CountSpawned(parallelRegistry) > spawnedBefore;
+        for (Entity entity : entities)
+        {
+            if (!entity.IsAlive())
+            {
+                // Freed ids are only reused by the next frame's spawns, so the signature is still the cleared one
+                isAnyKilled = true;
+                Check(!entity.HasComponent<Position>(), "an entity killed from a worker loses its components");
+            }
+        }
+    }
+    Check(isAnyKilled, "the frames kill entities from workers");
+    Check(isAnySpawned, "the frames spawn entities through per-thread command buffers");
+    Check(GetWorld(parallelRegistry) == GetWorld(serialRegistry), "parallel frames give the same world as frames without a pool");
+}
+
+static void TestSystemEntities()
+{
+    ThreadPool threadPool(3);
+    Registry registry;
+    registry.SetThreadPool(&threadPool);
+    Populate(registry);
+
+    const auto entities = registry.GetSystem<MovingSystem>().GetSystemEntities();
+    ThreadLocalBuffers<std::vector<int>> visitedIds(&threadPool);
+    registry.ParallelForEach(entities, CHUNK_SIZE, [&](Entity entity)
+    {
+        visitedIds.Local().push_back(entity.GetId());
+        if (entity.GetId() % 2 == 0)
+        {
+            entity.Kill();
+        }
+    });
+
+    std::vector<int> expectedIds;
+    for (Entity entity : entities)
+    {
+        expectedIds.push_back(entity.GetId());
+    }
+    std::sort(expectedIds.begin(), expectedIds.end());
+    Check(MergeIds(visitedIds) == expectedIds, "a parallel pass over system entities visits each of them exactly once");
+
+    registry.Update();
+    bool isEveryKillApplied = true;
+    for (int entityId : expectedIds)
+    {
+        isEveryKillApplied &= registry.GetEntityById(entityId).HasComponent<Velocity>() == (entityId % 2 != 0);
+    }
+    Check(isEveryKillApplied, "kills from a parallel pass over system entities are applied by the next Update()");
+    Check(static_cast<int>(registry.GetSystem<MovingSystem>().GetSystemEntities().size()) == static_cast<int>(expectedIds.size()) / 2,
+        "killed entities leave their systems");
+}
+
+int main()
+{
+    TestViewFrames();
+    TestSystemEntities();
+
+    return ReportChecks("parallel for each");
+}
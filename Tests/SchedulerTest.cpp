@@ -0,0 +1,270 @@
+#include "../Source/ECS/ECS.h"
+#include "../Source/ThreadPool/ThreadPool.h"
+#include "TestChecks.h"
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// SchedulerTest
+////////////////////////////////////////////////////////////////////////////////
+// Runs frames of systems with overlapping component access through the
+// SystemScheduler. Checks that every update starts only after the earlier
+// updates it conflicts with are done, and that the components end up exactly as
+// in a serial run of the same frames.
+////////////////////////////////////////////////////////////////////////////////
+
+struct ComponentA { uint32_t value = 0; };
+struct ComponentB { uint32_t value = 0; };
+struct ComponentC { uint32_t value = 0; };
+struct ComponentD { uint32_t value = 0; };
+
+// Records when its update started and ended on a clock shared by the frame
+class TimedSystem : public System
+{
+public:
+    int startTick = 0;
+    int endTick = 0;
+
+    template<typename TFunc>
+    void Run(std::atomic<int>& clock, TFunc&& func)
+    {
+        startTick = clock++;
+        for (auto entity : GetSystemEntities())
+        {
+            func(entity);
+        }
+        endTick = clock++;
+    }
+};
+
+class BFromASystem : public TimedSystem
+{
+public:
+    BFromASystem()
+    {
+        RequireComponent<ComponentA>();
+        RequireComponent<ComponentB>();
+        ReadsComponent<ComponentA>();
+        WritesComponent<ComponentB>();
+    }
+
+    void Update(std::atomic<int>& clock)
+    {
+        Run(clock, [](Entity entity)
+        {
+            entity.GetComponent<ComponentB>().value = entity.GetComponent<ComponentB>().value * 3 + entity.ReadComponent<ComponentA>().value;
+        });
+    }
+};
+
+class CFromBSystem : public TimedSystem
+{
+public:
+    CFromBSystem()
+    {
+        RequireComponent<ComponentB>();
+        RequireComponent<ComponentC>();
+        ReadsComponent<ComponentB>();
+        WritesComponent<ComponentC>();
+    }
+
+    void Update(std::atomic<int>& clock)
+    {
+        Run(clock, [](Entity entity)
+        {
+            entity.GetComponent<ComponentC>().value ^= entity.ReadComponent<ComponentB>().value * 7;
+        });
+    }
+};
+
+class DFromASystem : public TimedSystem
+{
+public:
+    DFromASystem()
+    {
+        RequireComponent<ComponentA>();
+        RequireComponent<ComponentD>();
+        ReadsComponent<ComponentA>();
+        WritesComponent<ComponentD>();
+    }
+
+    void Update(std::atomic<int>& clock)
+    {
+        Run(clock, [](Entity entity)
+        {
+            entity.GetComponent<ComponentD>().value += entity.ReadComponent<ComponentA>().value * 5;
+        });
+    }
+};
+
+class AFromDSystem : public TimedSystem
+{
+public:
+    AFromDSystem()
+    {
+        RequireComponent<ComponentA>();
+        RequireComponent<ComponentD>();
+        ReadsComponent<ComponentD>();
+        WritesComponent<ComponentA>();
+    }
+
+    void Update(std::atomic<int>& clock)
+    {
+        Run(clock, [](Entity entity)
+        {
+            entity.GetComponent<ComponentA>().value += entity.ReadComponent<ComponentD>().value % 13;
+        });
+    }
+};
+
+// Declares nothing, so it must run alone
+class UndeclaredSystem : public TimedSystem
+{
+public:
+    UndeclaredSystem()
+    {
+        RequireComponent<ComponentC>();
+    }
+
+    void Update(std::atomic<int>& clock)
+    {
+        Run(clock, [](Entity entity)
+        {
+            entity.GetComponent<ComponentC>().value += 1;
+        });
+    }
+};
+
+const int ENTITY_COUNT = 2000;
+const int FRAME_COUNT = 60;
+
+static void Populate(Registry& registry)
+{
+    registry.AddSystem<BFromASystem>();
+    registry.AddSystem<CFromBSystem>();
+    registry.AddSystem<DFromASystem>();
+    registry.AddSystem<AFromDSystem>();
+    registry.AddSystem<UndeclaredSystem>();
+
+    // Same seed for every registry, so they start from the same world
+    std::mt19937 random(12);
+    for (int i = 0; i < ENTITY_COUNT; i++)
+    {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<ComponentA>(ComponentA{ static_cast<uint32_t>(random() % 100) });
+        entity.AddComponent<ComponentB>(ComponentB{ static_cast<uint32_t>(random() % 100) });
+        if (i % 3 != 0)
+        {
+            entity.AddComponent<ComponentC>(ComponentC{ static_cast<uint32_t>(random() % 100) });
+        }
+        if (i % 4 != 0)
+        {
+            entity.AddComponent<ComponentD>(ComponentD{ static_cast<uint32_t>(random() % 100) });
+        }
+    }
+    registry.Update();
+}
+
+// The systems of a frame, in their serial order
+static std::vector<TimedSystem*> GetFrameSystems(Registry& registry)
+{
+    return {
+        &registry.GetSystem<BFromASystem>(),
+        &registry.GetSystem<DFromASystem>(),
+        &registry.GetSystem<CFromBSystem>(),
+        &registry.GetSystem<AFromDSystem>(),
+        &registry.GetSystem<UndeclaredSystem>()
+    };
+}
+
+static void TestConflicts()
+{
+    Registry registry;
+    Populate(registry);
+    const System& bFromA = registry.GetSystem<BFromASystem>();
+    const System& cFromB = registry.GetSystem<CFromBSystem>();
+    const System& dFromA = registry.GetSystem<DFromASystem>();
+    const System& aFromD = registry.GetSystem<AFromDSystem>();
+    const System& undeclared = registry.GetSystem<UndeclaredSystem>();
+
+    Check(!bFromA.ConflictsWith(dFromA), "systems that only share a read component do not conflict");
+    Check(bFromA.ConflictsWith(cFromB) && cFromB.ConflictsWith(bFromA), "a write conflicts with a read of the other system, both ways");
+    Check(dFromA.ConflictsWith(aFromD), "a write conflicts with a read of the other system");
+    Check(bFromA.ConflictsWith(bFromA), "a system conflicts with itself");
+    Check(!cFromB.ConflictsWith(dFromA), "systems with disjoint components do not conflict");
+    Check(undeclared.ConflictsWith(dFromA) && dFromA.ConflictsWith(undeclared), "a system that declares nothing conflicts with everything");
+}
+
+static void TestScheduledFrames()
+{
+    Registry serialRegistry;
+    Registry scheduledRegistry;
+    Populate(serialRegistry);
+    Populate(scheduledRegistry);
+
+    ThreadPool threadPool(3);
+    SystemScheduler scheduler(threadPool);
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        std::atomic<int> serialClock(0);
+        serialRegistry.GetSystem<BFromASystem>().Update(serialClock);
+        serialRegistry.GetSystem<DFromASystem>().Update(serialClock);
+        serialRegistry.GetSystem<CFromBSystem>().Update(serialClock);
+        serialRegistry.GetSystem<AFromDSystem>().Update(serialClock);
+        serialRegistry.GetSystem<UndeclaredSystem>().Update(serialClock);
+
+        std::atomic<int> clock(0);
+        scheduler.Schedule(scheduledRegistry.GetSystem<BFromASystem>(), clock);
+        scheduler.Schedule(scheduledRegistry.GetSystem<DFromASystem>(), clock);
+        scheduler.Schedule(scheduledRegistry.GetSystem<CFromBSystem>(), clock);
+        scheduler.Schedule(scheduledRegistry.GetSystem<AFromDSystem>(), clock);
+        scheduler.Schedule(scheduledRegistry.GetSystem<UndeclaredSystem>(), clock);
+        scheduler.Run();
+
+        // Every update must start after the earlier updates it conflicts with have ended
+        const std::vector<TimedSystem*> systems = GetFrameSystems(scheduledRegistry);
+        for (size_t i = 0; i < systems.size(); i++)
+        {
+            for (size_t j = 0; j < i; j++)
+            {
+                if (systems[j]->ConflictsWith(*systems[i]))
+                {
+                    Check(systems[j]->endTick < systems[i]->startTick, "an update waits for the earlier updates it conflicts with");
+                }
+            }
+        }
+
+        serialRegistry.Update();
+        scheduledRegistry.Update();
+    }
+
+    // Conflicting updates kept their serial order, so the worlds are identical
+    bool isIdentical = true;
+    for (int entityId = 0; entityId < ENTITY_COUNT; entityId++)
+    {
+        const Entity serial = serialRegistry.GetEntityById(entityId);
+        const Entity scheduled = scheduledRegistry.GetEntityById(entityId);
+        isIdentical &= serial.ReadComponent<ComponentA>().value == scheduled.ReadComponent<ComponentA>().value;
+        isIdentical &= serial.ReadComponent<ComponentB>().value == scheduled.ReadComponent<ComponentB>().value;
+        if (serial.HasComponent<ComponentC>())
+        {
+            isIdentical &= serial.ReadComponent<ComponentC>().value == scheduled.ReadComponent<ComponentC>().value;
+        }
+        if (serial.HasComponent<ComponentD>())
+        {
+            isIdentical &= serial.ReadComponent<ComponentD>().value == scheduled.ReadComponent<ComponentD>().value;
+        }
+    }
+    Check(isIdentical, "scheduled frames give the same components as serial frames");
+}
+
+int main()
+{
+    TestConflicts();
+    TestScheduledFrames();
+
+    return ReportChecks("scheduler");
+}
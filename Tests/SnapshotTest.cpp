@@ -0,0 +1,269 @@
+#include "../Source/ECS/ECS.h"
+#include "TestChecks.h"
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// SnapshotTest
+////////////////////////////////////////////////////////////////////////////////
+// Snapshots a world with dead ids, tags, groups and changes waiting for the
+// next Update(), changes it, and restores it. Checks that the restored world
+// matches a world that never went through a snapshot, before and after more
+// frames, and that truncated, corrupt or foreign blobs are rejected without
+// touching the world. Built once per storage backend.
+////////////////////////////////////////////////////////////////////////////////
+
+struct Position { int x = 0; int y = 0; };
+
+// Not trivially copyable, so it is written member by member
+struct Name
+{
+    std::string value;
+
+    template<typename TWriter>
+    void Serialize(TWriter& writer) const
+    {
+        writer.Write(value);
+    }
+
+    template<typename TReader>
+    void Deserialize(TReader& reader)
+    {
+        reader.Read(value);
+    }
+};
+
+// Stored by one registry only, so the others cannot restore its snapshots
+struct Velocity { int dx = 0; };
+
+// Neither trivially copyable nor serializable
+struct Script { std::string source; };
+
+class NamedSystem : public System
+{
+public:
+    NamedSystem()
+    {
+        RequireComponent<Position>();
+        RequireComponent<Name>();
+    }
+};
+
+// Same world every time: dead ids on the free list, tags, groups, and adds, kills and component changes that
+// only the next Update() applies
+static void Build(Registry& registry)
+{
+    registry.AddSystem<NamedSystem>();
+    std::vector<Entity> entities;
+    for (int i = 0; i < 40; i++)
+    {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<Position>(Position{ i, i * 2 });
+        if (i % 3 != 0)
+        {
+            entity.AddComponent<Name>(Name{ "entity-" + std::to_string(i) });
+        }
+        entities.push_back(entity);
+    }
+    entities[0].Tag("player");
+    entities[5].Tag("boss");
+    for (int i = 0; i < 40; i += 4)
+    {
+        entities[i].Group("enemies");
+    }
+    registry.Update();
+
+    for (int i = 1; i < 40; i += 7)
+    {
+        entities[i].Kill();
+    }
+    registry.Update();
+
+    Entity pending = registry.CreateEntity();
+    pending.AddComponent<Position>(Position{ -1, -1 });
+    pending.AddComponent<Name>(Name{ "pending" });
+    entities[3].AddComponent<Name>(Name{ "renamed" });
+    entities[10].RemoveComponent<Name>();
+    entities[12].Kill();
+}
+
+// Everything a game can observe of the world, sorted so the storage order does not matter. Restore() rebuilds system
+// membership from the current signatures, so components changed since the last Update() only match up after the
+// next one, and membership is left out until then.
+typedef std::tuple<int, int, int, int, std::string, bool, bool, bool, bool> EntityState;
+
+static std::vector<EntityState> Describe(Registry& registry, bool isMembershipDescribed = true)
+{
+    std::vector<EntityState> world;
+    registry.View<const Position>().Each([&](Entity entity, const Position& position)
+    {
+        const std::string name = entity.HasComponent<Name>() ? entity.ReadComponent<Name>().value : "-";
+        const auto systemEntities = registry.GetSystem<NamedSystem>().GetSystemEntities();
+        const bool isInSystem = isMembershipDescribed && std::find(systemEntities.begin(), systemEntities.end(), entity) != systemEntities.end();
+        world.emplace_back(entity.GetId(), entity.GetGeneration(), position.x, position.y, name,
+            entity.HasTag("player"), entity.HasTag("boss"), entity.BelongsToGroup("enemies"), isInSystem);
+    });
+    std::sort(world.begin(), world.end());
+    return world;
+}
+
+// Another frame on top of the world, creating entities on the freed ids
+static void PlayFrame(Registry& registry)
+{
+    registry.Update();
+    for (int i = 0; i < 8; i++)
+    {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<Position>(Position{ 100 + i, 0 });
+        entity.AddComponent<Name>(Name{ "spawned" });
+    }
+    registry.View<Position>().Each([](Position& position)
+    {
+        position.x += 1;
+    });
+    registry.Update();
+}
+
+// Changes that a restore has to undo
+static void Scramble(Registry& registry)
+{
+    registry.Update();
+    registry.View<const Position>().Each([](Entity entity, const Position&)
+    {
+        if (entity.GetId() % 2 == 0)
+        {
+            entity.Kill();
+        }
+    });
+    registry.Update();
+    for (int i = 0; i < 20; i++)
+    {
+        Entity entity = registry.CreateEntity();
+        entity.AddComponent<Position>(Position{ 0, i });
+        entity.Tag("player");
+    }
+    registry.Update();
+}
+
+static void TestRoundTrip()
+{
+    Registry restored;
+    Registry reference;
+    Build(restored);
+    Build(reference);
+
+    const std::vector<std::byte> snapshot = restored.Snapshot();
+    Check(!snapshot.empty(), "a world of serializable components can be snapshot");
+
+    Scramble(restored);
+    CommandBuffer commandBuffer;
+    Entity stray = commandBuffer.CreateEntity();
+    commandBuffer.AddComponent<Position>(stray, Position{ 7, 7 });
+    restored.SubmitCommandBuffer(commandBuffer);
+
+    Check(restored.Restore(snapshot), "a snapshot of the same registry is restored");
+    Check(Describe(restored, false) == Describe(reference, false), "a restored world matches the world that was snapshot");
+
+    // Pending adds, kills and component changes, the free list and the dropped command buffer show up here
+    PlayFrame(restored);
+    PlayFrame(reference);
+    Check(Describe(restored) == Describe(reference), "a restored world plays on like the world that was snapshot");
+
+    std::vector<std::byte> again;
+    reference.Snapshot(again);
+    Check(restored.Restore(again) && Describe(restored) == Describe(reference), "a snapshot buffer can be reused");
+}
+
+static void TestRejectedBlobs()
+{
+    Registry registry;
+    Build(registry);
+    const std::vector<std::byte> snapshot = registry.Snapshot();
+    Scramble(registry);
+    const auto before = Describe(registry);
+
+    bool isEveryTruncationRejected = true;
+    for (size_t size = 0; size < snapshot.size(); size++)
+    {
+        const std::vector<std::byte> truncated(snapshot.begin(), snapshot.begin() + size);
+        isEveryTruncationRejected &= !registry.Restore(truncated);
+    }
+    Check(isEveryTruncationRejected, "every truncation of a snapshot is rejected");
+
+    std::vector<std::byte> extended = snapshot;
+    extended.push_back(std::byte{ 0 });
+    Check(!registry.Restore(extended), "a snapshot with trailing bytes is rejected");
+
+    std::vector<std::byte> wrongVersion = snapshot;
+    wrongVersion[4] = std::byte{ 0x7f };
+    Check(!registry.Restore(wrongVersion), "a snapshot of another version is rejected");
+
+    // The entity count follows the header, a count past the entity arrays is rejected before anything is read
+    std::vector<std::byte> corrupt = snapshot;
+    const int entityCount = 1 << 20;
+    std::copy_n(reinterpret_cast<const std::byte*>(&entityCount), sizeof(int), corrupt.begin() + 16);
+    Check(!registry.Restore(corrupt), "a snapshot with an entity count past its arrays is rejected");
+
+    Registry foreign;
+    Build(foreign);
+    foreign.GetEntityById(2).AddComponent<Velocity>(Velocity{ 1 });
+    Check(!registry.Restore(foreign.Snapshot()), "a snapshot with a component type the registry never stored is rejected");
+
+    Check(Describe(registry) == before, "rejected snapshots leave the world untouched");
+}
+
+// Overwrites the int at offset of a copy of the snapshot
+static std::vector<std::byte> Corrupt(const std::vector<std::byte>& snapshot, size_t offset, int value)
+{
+    std::vector<std::byte> corrupt = snapshot;
+    std::copy_n(reinterpret_cast<const std::byte*>(&value), sizeof(int), corrupt.begin() + offset);
+    return corrupt;
+}
+
+static void TestCorruptSections()
+{
+    // Both backends write a section of two positions as its size, the count, the two entity ids, then the positions
+    Registry registry;
+    const int marker = 123456;
+    registry.CreateEntity().AddComponent<Position>(Position{ marker, 0 });
+    registry.CreateEntity().AddComponent<Position>();
+    registry.Update();
+    const std::vector<std::byte> snapshot = registry.Snapshot();
+
+    const std::byte* markerBytes = reinterpret_cast<const std::byte*>(&marker);
+    const size_t markerOffset = std::search(snapshot.begin(), snapshot.end(), markerBytes, markerBytes + sizeof(int)) - snapshot.begin();
+    Check(markerOffset >= 16 && markerOffset < snapshot.size(), "the position section is found");
+    if (markerOffset < 16 || markerOffset >= snapshot.size())
+    {
+        return;
+    }
+    const size_t countOffset = markerOffset - 3 * sizeof(int);
+    const size_t secondIdOffset = markerOffset - sizeof(int);
+
+    Check(!registry.Restore(Corrupt(snapshot, countOffset, 1 << 28)), "a section with a count past its size is rejected");
+    Check(!registry.Restore(Corrupt(snapshot, countOffset, -1)), "a section with a negative count is rejected");
+    Check(!registry.Restore(Corrupt(snapshot, secondIdOffset, -5)), "a section with a negative entity id is rejected");
+    Check(!registry.Restore(Corrupt(snapshot, secondIdOffset, 1000)), "a section with an entity id past the entity slots is rejected");
+    Check(!registry.Restore(Corrupt(snapshot, secondIdOffset, 0)), "a section listing an entity twice is rejected");
+    Check(registry.Restore(snapshot) && registry.GetEntityById(0).ReadComponent<Position>().x == marker, "the unchanged snapshot is restored");
+}
+
+static void TestUnserializable()
+{
+    Registry registry;
+    Build(registry);
+    registry.GetEntityById(2).AddComponent<Script>(Script{ "print()" });
+    Check(registry.Snapshot().empty(), "a world with a component that cannot be serialized gives an empty snapshot");
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestRejectedBlobs();
+    TestCorruptSections();
+    TestUnserializable();
+
+    return ReportChecks("snapshot");
+}
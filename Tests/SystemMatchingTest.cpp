@@ -0,0 +1,205 @@
+#include "../Source/ECS/ECS.h"
+#include "TestChecks.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// SystemMatchingTest
+////////////////////////////////////////////////////////////////////////////////
+// Adds and removes components on entities that already joined their systems.
+// Checks that system membership follows the new signatures on the next
+// Update(), and not before, that replacing a component is not a signature
+// change, and that random frames of adds, removes, kills and new entities keep
+// every system holding exactly the live entities that match it.
+////////////////////////////////////////////////////////////////////////////////
+
+struct ComponentA { int value = 0; };
+struct ComponentB { int value = 0; };
+struct ComponentC { int value = 0; };
+
+class ASystem : public System
+{
+public:
+    ASystem()
+    {
+        RequireComponent<ComponentA>();
+    }
+};
+
+class ABSystem : public System
+{
+public:
+    ABSystem()
+    {
+        RequireComponent<ComponentA>();
+        RequireComponent<ComponentB>();
+    }
+};
+
+class BCSystem : public System
+{
+public:
+    BCSystem()
+    {
+        RequireComponent<ComponentB>();
+        RequireComponent<ComponentC>();
+    }
+};
+
+static void AddSystems(Registry& registry)
+{
+    registry.AddSystem<ASystem>();
+    registry.AddSystem<ABSystem>();
+    registry.AddSystem<BCSystem>();
+}
+
+// How many times the system holds the entity, so duplicates are caught too
+template<typename TSystem>
+static int CountInSystem(Registry& registry, Entity entity)
+{
+    const auto entities = registry.GetSystem<TSystem>().GetSystemEntities();
+    return static_cast<int>(std::count(entities.begin(), entities.end(), entity));
+}
+
+static void TestAddAndRemove()
+{
+    Registry registry;
+    AddSystems(registry);
+    Entity entity = registry.CreateEntity();
+    entity.AddComponent<ComponentA>();
+    registry.Update();
+    Check(CountInSystem<ASystem>(registry, entity) == 1 && CountInSystem<ABSystem>(registry, entity) == 0, "a new entity joins the systems it matches");
+
+    entity.AddComponent<ComponentB>();
+    Check(CountInSystem<ABSystem>(registry, entity) == 0, "an added component changes system membership only on the next Update()");
+    registry.Update();
+    Check(CountInSystem<ASystem>(registry, entity) == 1 && CountInSystem<ABSystem>(registry, entity) == 1, "an added component joins the systems that now match");
+    Check(CountInSystem<BCSystem>(registry, entity) == 0, "an added component leaves the systems that still do not match alone");
+
+    entity.AddComponent<ComponentB>(ComponentB{ 5 });
+    registry.Update();
+    Check(CountInSystem<ABSystem>(registry, entity) == 1, "replacing a component is not a signature change");
+    Check(entity.ReadComponent<ComponentB>().value == 5, "replacing a component stores the new value");
+
+    entity.RemoveComponent<ComponentA>();
+    Check(CountInSystem<ASystem>(registry, entity) == 1, "a removed component changes system membership only on the next Update()");
+    registry.Update();
+    Check(CountInSystem<ASystem>(registry, entity) == 0 && CountInSystem<ABSystem>(registry, entity) == 0, "a removed component leaves the systems that no longer match");
+
+    entity.AddComponent<ComponentC>();
+    entity.RemoveComponent<ComponentC>();
+    entity.AddComponent<ComponentA>();
+    registry.Update();
+    Check(CountInSystem<BCSystem>(registry, entity) == 0, "a component added and removed in the same frame leaves membership alone");
+    Check(CountInSystem<ASystem>(registry, entity) == 1 && CountInSystem<ABSystem>(registry, entity) == 1, "several changes in a frame join each system once");
+
+    entity.RemoveComponent<ComponentB>();
+    entity.Kill();
+    registry.Update();
+    Check(CountInSystem<ASystem>(registry, entity) == 0 && CountInSystem<ABSystem>(registry, entity) == 0, "an entity changed and killed in the same frame leaves every system");
+}
+
+static void TestLateSystem()
+{
+    Registry registry;
+    registry.AddSystem<ASystem>();
+    Entity entity = registry.CreateEntity();
+    entity.AddComponent<ComponentA>();
+    registry.Update();
+
+    // Systems added after the entity joined still have to hear about its changes
+    registry.AddSystem<ABSystem>();
+    entity.AddComponent<ComponentB>();
+    registry.Update();
+    Check(CountInSystem<ABSystem>(registry, entity) == 1, "a system added later is re-matched when a component it requires is added");
+}
+
+// Every system holds exactly the live entities that match it, once each
+template<typename TSystem>
+static bool IsMembershipExact(Registry& registry, const std::vector<Entity>& entities, bool (*isMatching)(Entity))
+{
+    std::vector<Entity> expected;
+    for (Entity entity : entities)
+    {
+        if (entity.IsAlive() && isMatching(entity))
+        {
+            expected.push_back(entity);
+        }
+    }
+    const auto systemEntities = registry.GetSystem<TSystem>().GetSystemEntities();
+    std::vector<Entity> actual(systemEntities.begin(), systemEntities.end());
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    return actual == expected;
+}
+
+template<typename TComponent>
+static void Toggle(Entity entity)
+{
+    if (entity.HasComponent<TComponent>())
+    {
+        entity.RemoveComponent<TComponent>();
+    }
+    else
+    {
+        entity.AddComponent<TComponent>();
+    }
+}
+
+static void TestRandomFrames()
+{
+    Registry registry;
+    AddSystems(registry);
+    std::mt19937 random(7);
+    std::vector<Entity> entities;
+
+    bool isExact = true;
+    for (int frame = 0; frame < 200; frame++)
+    {
+        for (int i = 0; i < 20; i++)
+        {
+            if (entities.empty() || random() % 8 == 0)
+            {
+                entities.push_back(registry.CreateEntity());
+            }
+            Entity entity = entities[random() % entities.size()];
+            if (!entity.IsAlive())
+            {
+                continue;
+            }
+            switch (random() % 5)
+            {
+                case 0: Toggle<ComponentA>(entity); break;
+                case 1: Toggle<ComponentB>(entity); break;
+                case 2: Toggle<ComponentC>(entity); break;
+                case 3: entity.AddComponent<ComponentA>(ComponentA{ frame }); break;
+                case 4: if (random() % 4 == 0) { entity.Kill(); } break;
+            }
+        }
+        registry.Update();
+
+        isExact &= IsMembershipExact<ASystem>(registry, entities, [](Entity entity)
+        {
+            return entity.HasComponent<ComponentA>();
+        });
+        isExact &= IsMembershipExact<ABSystem>(registry, entities, [](Entity entity)
+        {
+            return entity.HasComponent<ComponentA>() && entity.HasComponent<ComponentB>();
+        });
+        isExact &= IsMembershipExact<BCSystem>(registry, entities, [](Entity entity)
+        {
+            return entity.HasComponent<ComponentB>() && entity.HasComponent<ComponentC>();
+        });
+    }
+    Check(isExact, "after every frame of random changes, each system holds exactly the live entities that match it");
+}
+
+int main()
+{
+    TestAddAndRemove();
+    TestLateSystem();
+    TestRandomFrames();
+
+    return ReportChecks("system matching");
+}
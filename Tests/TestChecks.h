@@ -0,0 +1,40 @@
+#ifndef TESTCHECKS_H
+#define TESTCHECKS_H
+
+#include <cstdio>
+
+////////////////////////////////////////////////////////////////////////////////
+// TestChecks
+////////////////////////////////////////////////////////////////////////////////
+// Shared by the test programs. Check() prints and counts every condition that
+// does not hold, and ReportChecks() ends main() with a summary and an exit
+// code that CTest reads as a failure if any check failed.
+////////////////////////////////////////////////////////////////////////////////
+
+// Each test is a program of its own, so the count covers the whole test
+inline int failureCount = 0;
+
+inline void Check(bool condition, const char* description)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", description);
+        failureCount++;
+    }
+}
+
+// Prints how many of the checks failed, returns the exit code of the test
+inline int ReportChecks(const char* name)
+{
+    if (failureCount == 0)
+    {
+        std::printf("All %s checks passed\n", name);
+    }
+    else
+    {
+        std::printf("%d %s checks failed\n", failureCount, name);
+    }
+    return failureCount == 0 ? 0 : 1;
+}
+
+#endif